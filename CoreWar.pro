@@ -7,4 +7,6 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     CoreWarTests.pro \
-	CoreWarApp.pro
+	CoreWarApp.pro \
+	CoreWarCli.pro \
+	CoreWarBench.pro
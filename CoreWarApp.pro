@@ -7,16 +7,36 @@ INCLUDEPATH += .
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 HEADERS += gui/mainwindow.h \
+		   gui/coreview.h \
+		   gui/logmodel.h \
 		   src/Assembler.hpp \
+		   src/AssemblyCache.hpp \
+		   src/InstructionLog.hpp \
+		   src/Heatmap.hpp \
+		   src/Lexer.hpp \
+		   src/SymbolTable.hpp \
+		   src/MappedFile.hpp \
+		   src/MatchRunner.hpp \
+		   src/ObjectFile.hpp \
 		   src/Tokenizer.hpp \
 		   src/VirtualMachine.hpp
 
 FORMS += gui/mainwindow.ui
 
 SOURCES += gui/mainwindow.cpp \
+		   gui/coreview.cpp \
+		   gui/logmodel.cpp \
 		   src/Assembler.cpp \
+		   src/AssemblyCache.cpp \
+		   src/InstructionLog.cpp \
+		   src/Heatmap.cpp \
+		   src/Lexer.cpp \
+		   src/SymbolTable.cpp \
+		   src/MappedFile.cpp \
+		   src/MatchRunner.cpp \
+		   src/ObjectFile.cpp \
 		   src/Tokenizer.cpp \
 		   src/VirtualMachine.cpp \
 		   src/main.cpp
 
-CONFIG += c++11
+CONFIG += c++1z
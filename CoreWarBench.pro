@@ -0,0 +1,27 @@
+TEMPLATE = app
+
+TARGET = CoreWarBench
+
+INCLUDEPATH += .
+
+CONFIG += console c++1z release
+CONFIG -= qt app_bundle
+
+HEADERS += src/Assembler.hpp \
+		   src/Heatmap.hpp \
+		   src/Lexer.hpp \
+		   src/SymbolTable.hpp \
+		   src/MappedFile.hpp \
+		   src/ObjectFile.hpp \
+		   src/Tokenizer.hpp \
+		   src/VirtualMachine.hpp
+
+SOURCES += bench/main.cpp \
+		   src/Assembler.cpp \
+		   src/Heatmap.cpp \
+		   src/Lexer.cpp \
+		   src/SymbolTable.cpp \
+		   src/MappedFile.cpp \
+		   src/ObjectFile.cpp \
+		   src/Tokenizer.cpp \
+		   src/VirtualMachine.cpp
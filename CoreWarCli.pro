@@ -0,0 +1,35 @@
+TEMPLATE = app
+
+TARGET = CoreWarCli
+
+INCLUDEPATH += .
+
+CONFIG += console c++1z
+CONFIG -= qt app_bundle
+
+HEADERS += src/Assembler.hpp \
+		   src/AssemblyCache.hpp \
+		   src/BulkAssembler.hpp \
+		   src/Heatmap.hpp \
+		   src/Lexer.hpp \
+		   src/SymbolTable.hpp \
+		   src/ThreadPool.hpp \
+		   src/MappedFile.hpp \
+		   src/ObjectFile.hpp \
+		   src/Tokenizer.hpp \
+		   src/VirtualMachine.hpp \
+		   src/WarriorArchive.hpp
+
+SOURCES += cli/main.cpp \
+		   src/Assembler.cpp \
+		   src/AssemblyCache.cpp \
+		   src/BulkAssembler.cpp \
+		   src/Heatmap.cpp \
+		   src/Lexer.cpp \
+		   src/SymbolTable.cpp \
+		   src/ThreadPool.cpp \
+		   src/MappedFile.cpp \
+		   src/ObjectFile.cpp \
+		   src/Tokenizer.cpp \
+		   src/VirtualMachine.cpp \
+		   src/WarriorArchive.cpp
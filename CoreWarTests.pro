@@ -8,13 +8,37 @@ INCLUDEPATH += .
 
 HEADERS += \
 		src/Assembler.hpp \
+		src/AssemblyCache.hpp \
+		src/BulkAssembler.hpp \
+		src/ThreadPool.hpp \
+		src/InstructionLog.hpp \
+		src/Heatmap.hpp \
+		src/Lexer.hpp \
+		src/SymbolTable.hpp \
+		src/MappedFile.hpp \
+		src/MatchRunner.hpp \
+		src/ObjectFile.hpp \
 		src/Tokenizer.hpp \
-		src/VirtualMachine.hpp
+		src/Tournament.hpp \
+		src/VirtualMachine.hpp \
+		src/WarriorArchive.hpp
 
 SOURCES += \
 		src/Assembler.cpp \
+		src/AssemblyCache.cpp \
+		src/BulkAssembler.cpp \
+		src/ThreadPool.cpp \
+		src/InstructionLog.cpp \
+		src/Heatmap.cpp \
+		src/Lexer.cpp \
+		src/SymbolTable.cpp \
+		src/MappedFile.cpp \
+		src/MatchRunner.cpp \
+		src/ObjectFile.cpp \
 		src/Tokenizer.cpp \
+		src/Tournament.cpp \
 		src/VirtualMachine.cpp \
+		src/WarriorArchive.cpp \
 		tests/CoreWarTests.cpp
 
-CONFIG += c++11
+CONFIG += c++1z
@@ -0,0 +1,564 @@
+#include "src/VirtualMachine.hpp"
+#include "src/Assembler.hpp"
+#include "src/Tokenizer.hpp"
+#include "src/Lexer.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <cstdlib>
+
+//counts every heap allocation made by the process
+namespace
+{
+
+std::atomic<unsigned long long> allocations(0);
+
+//kept out of line, so the compiler does not pair the malloc and free
+//in them with the replaced new and delete below
+[[gnu::noinline]] void* allocate(std::size_t size)
+{
+	++allocations;
+
+	if(void* p = std::malloc(size ? size : 1))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void release(void* p) noexcept
+{
+	std::free(p);
+}
+
+}
+
+void* operator new(std::size_t size)
+{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	release(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	release(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	release(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	release(p);
+}
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+using Instruction = VirtualMachine::Core::Instruction;
+
+const char* Imp =
+		"mov.i 0, 1\n";
+
+const char* Dwarf =
+		"add.ab #4, 3\n"
+		"mov.i 2, @2\n"
+		"jmp -2\n"
+		"kil #0, #0\n";
+
+const char* Bomber =
+		"start: mov.i bomb, @ptr\n"
+		"       add.ab #7, ptr\n"
+		"       jmp start\n"
+		"ptr:   kil #0, #15\n"
+		"bomb:  kil #0, #0\n";
+
+const char* Replicator =
+		"top:  mov.i @src, @dst\n"
+		"      add.ab #1, src\n"
+		"      add.ab #1, dst\n"
+		"      frk top\n"
+		"      jmp top\n"
+		"src:  kil #0, #-4\n"
+		"dst:  kil #0, #1000\n";
+
+//the baseline keeps six significant digits, which is all a count
+//compared against it can be held to, in percent
+const double CountTolerance = 1e-3;
+
+//each workload is repeated until it has run this many cycles
+const unsigned long long CyclesPerSample = 4000000;
+
+//odd, so the median is one of the samples
+const unsigned int Samples = 11;
+
+const unsigned int GeneratedLines = 20000;
+
+/*!
+ * \brief Measured value and the direction in which it improves
+ */
+struct Metric
+{
+	double value;
+
+	bool higherIsBetter;
+
+	//timings vary between runs and are compared within the tolerance,
+	//counts are not
+	bool timed;
+};
+
+using Results = std::map<std::string, Metric>;
+
+double seconds(Clock::time_point since)
+{
+	return std::chrono::duration<double>(Clock::now() - since).count();
+}
+
+double median(std::vector<double> samples)
+{
+	std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+
+	return samples[samples.size() / 2];
+}
+
+std::vector<Instruction> assemble(const char* source)
+{
+	Assembler::Result res = Assembler().assemble(source);
+
+	if(!res.success)
+		throw std::runtime_error("Benchmark warrior failed to assemble");
+
+	return res.instructions;
+}
+
+std::string generateSource(unsigned int lines)
+{
+	static const char* ops[] = {"mov.i", "add.ab", "sub.f", "mul.b", "jmz.b", "jmn.a", "beq.i", "blt.x"};
+	static const char* modes[] = {"#", "$", "@", "*"};
+
+	//labels cannot be immediate, so the A operand skips the first mode
+
+	std::ostringstream out;
+
+	for(unsigned int i = 0; i < lines; ++i)
+	{
+		out << "l" << i << ":\t" << ops[i % 8] << " "
+			<< modes[1 + i % 3] << "l" << (i * 7 + 3) % lines << ", "
+			<< modes[(i / 4) % 4] << (static_cast<int>(i % 200) - 100)
+			<< "\t; generated line " << i << "\n";
+	}
+
+	return out.str();
+}
+
+//plays the warrior against itself until enough cycles have run,
+//stepping through executeCycle() as the GUI does
+template<class VM>
+void stepped(VM& vm, const std::vector<Instruction>& w, unsigned long long& cycles)
+{
+	vm.reset();
+	vm.loadProgram(w, 0);
+	vm.loadProgram(w, 4000, false);
+
+	while(vm.getState() == VirtualMachine::ONGOING)
+	{
+		vm.executeCycle();
+		++cycles;
+	}
+}
+
+template<class VM>
+void batched(VM& vm, const std::vector<Instruction>& w, unsigned long long& cycles)
+{
+	vm.reset();
+	vm.loadProgram(w, 0);
+	vm.loadProgram(w, 4000, false);
+
+	cycles += vm.runToCompletion().cycles;
+}
+
+template<class VM, class Play>
+void measureVm(Results& results, const std::string& name, VM& vm,
+			   const std::vector<Instruction>& w, Play play)
+{
+	std::vector<double> rates;
+	rates.reserve(Samples);
+
+	unsigned long long totalCycles = 0;
+	unsigned long long allocs = allocations;
+
+	for(unsigned int s = 0; s < Samples; ++s)
+	{
+		unsigned long long cycles = 0;
+
+		Clock::time_point start = Clock::now();
+
+		while(cycles < CyclesPerSample)
+			play(vm, w, cycles);
+
+		rates.push_back(cycles / seconds(start));
+		totalCycles += cycles;
+	}
+
+	//every sample plays the same matches, so the count over all of them
+	//does not depend on timing
+	double allocsPerCycle = static_cast<double>(allocations - allocs) / totalCycles;
+	double rate = median(rates);
+
+	results[name + ".cycles_per_sec"] = {rate, true, true};
+	results[name + ".ns_per_instruction"] = {1e9 / (2 * rate), false, true};
+	results[name + ".allocs_per_cycle"] = {allocsPerCycle, false, false};
+}
+
+//takes a snapshot and restores it every SnapshotInterval cycles, as a
+//search over continuations of a match would
+template<class VM>
+void measureSnapshots(Results& results, const std::string& name, const std::vector<Instruction>& w)
+{
+	const unsigned int SnapshotInterval = 10;
+	const unsigned int Snapshots = 10000;
+
+	std::unique_ptr<VM> vm(new VM);
+
+	vm->loadProgram(w, 0);
+	vm->loadProgram(w, 4000, false);
+
+	typename VM::Snapshot start = vm->snapshot();
+
+	std::vector<double> snapshots;
+	std::vector<double> restores;
+
+	for(unsigned int s = 0; s < Samples; ++s)
+	{
+		double taking = 0;
+		double restoring = 0;
+
+		for(unsigned int i = 0; i < Snapshots; ++i)
+		{
+			if(vm->getState() != VirtualMachine::ONGOING)
+				vm->restore(start);
+
+			vm->runCycles(SnapshotInterval);
+
+			Clock::time_point begin = Clock::now();
+
+			typename VM::Snapshot snapshot = vm->snapshot();
+
+			taking += seconds(begin);
+
+			vm->runCycles(SnapshotInterval);
+
+			begin = Clock::now();
+
+			vm->restore(snapshot);
+
+			restoring += seconds(begin);
+		}
+
+		snapshots.push_back(1e9 * taking / Snapshots);
+		restores.push_back(1e9 * restoring / Snapshots);
+	}
+
+	results["snapshot." + name + ".ns_per_snapshot"] = {median(snapshots), false, true};
+	results["snapshot." + name + ".ns_per_restore"] = {median(restores), false, true};
+}
+
+void measureAssembler(Results& results)
+{
+	std::string source = generateSource(GeneratedLines);
+
+	Assembler as;
+
+	std::vector<double> rates;
+
+	for(unsigned int s = 0; s < Samples; ++s)
+	{
+		Clock::time_point start = Clock::now();
+
+		if(!as.assemble(source).success)
+			throw std::runtime_error("Generated source failed to assemble");
+
+		rates.push_back(GeneratedLines / seconds(start));
+	}
+
+	results["assembler.lines_per_sec"] = {median(rates), true, true};
+}
+
+void measureTokenizer(Results& results)
+{
+	std::istringstream in(generateSource(GeneratedLines));
+	std::vector<std::string> lines;
+
+	for(std::string line; std::getline(in, line);)
+		lines.push_back(line);
+
+	std::vector<double> times;
+
+	for(unsigned int s = 0; s < Samples; ++s)
+	{
+		unsigned long long tokens = 0;
+
+		Tokenizer t(std::string(), " \t,", ";:", true);
+
+		Clock::time_point start = Clock::now();
+
+		for(const auto& line : lines)
+		{
+			t.assign(line);
+
+			while(t.isToken())
+			{
+				t.next();
+				++tokens;
+			}
+		}
+
+		times.push_back(1e9 * seconds(start) / tokens);
+	}
+
+	results["tokenizer.ns_per_token"] = {median(times), false, true};
+}
+
+void measureLexer(Results& results)
+{
+	std::string source = generateSource(GeneratedLines);
+	std::vector<std::string_view> lines;
+
+	for(std::size_t pos = 0, eol; pos < source.size(); pos = eol + 1)
+	{
+		eol = source.find('\n', pos);
+		lines.push_back(std::string_view(source).substr(pos, eol - pos));
+	}
+
+	std::vector<double> times;
+
+	for(unsigned int s = 0; s < Samples; ++s)
+	{
+		unsigned long long tokens = 0;
+		std::size_t bytes = 0;
+
+		Lexer lex(" \t,", ";:");
+
+		Clock::time_point start = Clock::now();
+
+		for(auto line : lines)
+		{
+			lex.assign(line);
+
+			while(lex.isToken())
+			{
+				bytes += lex.next().size();
+				++tokens;
+			}
+		}
+
+		times.push_back(1e9 * seconds(start) / tokens);
+
+		//keeps the token loop from being optimized away
+		if(!bytes)
+			throw std::runtime_error("Generated source has no tokens");
+	}
+
+	results["lexer.ns_per_token"] = {median(times), false, true};
+}
+
+Results run()
+{
+	Results results;
+
+	std::map<std::string, std::vector<Instruction>> warriors = {
+		{"imp", assemble(Imp)},
+		{"dwarf", assemble(Dwarf)},
+		{"bomber", assemble(Bomber)},
+		{"replicator", assemble(Replicator)}
+	};
+
+	VirtualMachine sw(8000, VirtualMachine::SWITCH);
+	VirtualMachine pre(8000, VirtualMachine::PREDECODED);
+	std::unique_ptr<HeadlessVirtualMachine> headless(new HeadlessVirtualMachine);
+
+	for(const auto& w : warriors)
+	{
+		measureVm(results, "vm.switch." + w.first, sw, w.second, stepped<VirtualMachine>);
+		measureVm(results, "vm.predecoded." + w.first, pre, w.second, stepped<VirtualMachine>);
+		measureVm(results, "headless." + w.first, *headless, w.second, batched<HeadlessVirtualMachine>);
+	}
+
+	//the standard machine also shares the heatmaps of its reports
+	measureSnapshots<HeadlessVirtualMachine>(results, "headless", warriors["bomber"]);
+	measureSnapshots<StandardVirtualMachine>(results, "standard", warriors["bomber"]);
+
+	measureAssembler(results);
+	measureTokenizer(results);
+	measureLexer(results);
+
+	return results;
+}
+
+//reads a flat JSON object of numbers, as written by writeJson()
+std::map<std::string, double> readJson(const char* fname)
+{
+	std::ifstream in(fname);
+
+	if(!in)
+		throw std::runtime_error(std::string("Cannot open baseline ") + fname);
+
+	std::stringstream buf;
+	buf << in.rdbuf();
+
+	std::string text = buf.str();
+	std::map<std::string, double> values;
+
+	for(std::size_t pos = text.find('"'); pos != std::string::npos; pos = text.find('"', pos))
+	{
+		std::size_t end = text.find('"', pos + 1);
+		std::size_t colon = text.find(':', end);
+
+		if(end == std::string::npos || colon == std::string::npos)
+			break;
+
+		values[text.substr(pos + 1, end - pos - 1)] = std::strtod(text.c_str() + colon + 1, NULL);
+
+		pos = text.find_first_of(",}", colon);
+	}
+
+	return values;
+}
+
+void writeJson(const char* fname, const Results& results)
+{
+	std::ofstream out(fname);
+
+	out << "{\n";
+
+	for(auto it = results.begin(); it != results.end(); ++it)
+		out << "\t\"" << it->first << "\": " << std::setprecision(6) << it->second.value
+			<< (std::next(it) == results.end() ? "\n" : ",\n");
+
+	out << "}\n";
+}
+
+//baselines hold absolute timings, so they only mean something on the
+//machine that recorded them; regenerate bench/baseline.json there with -w
+void usage(const char* name)
+{
+	std::cerr << "usage: " << name << " [-b baseline.json] [-w output.json] [-t tolerance%]\n"
+			  << "  -t applies to timings, 25% by default; counts such as allocations\n"
+			  << "     per cycle regress on any growth\n";
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const char* baseline = NULL;
+	const char* output = NULL;
+	double tolerance = 25;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if(i + 1 == argc)
+		{
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		if(arg == "-b")
+			baseline = argv[++i];
+		else if(arg == "-w")
+			output = argv[++i];
+		else if(arg == "-t")
+			tolerance = std::atof(argv[++i]);
+		else
+		{
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	Results results;
+	std::map<std::string, double> base;
+
+	try
+	{
+		if(baseline)
+			base = readJson(baseline);
+
+		results = run();
+	}
+
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << '\n';
+
+		return EXIT_FAILURE;
+	}
+
+	unsigned int regressions = 0;
+
+	for(const auto& r : results)
+	{
+		std::cout << std::left << std::setw(40) << r.first
+				  << std::right << std::setw(14) << std::setprecision(4) << r.second.value;
+
+		auto b = base.find(r.first);
+
+		if(b != base.end() && b->second > 0)
+		{
+			double change = 100 * (r.second.value / b->second - 1);
+
+			if(!r.second.higherIsBetter)
+				change = -change;
+
+			std::cout << std::setw(10) << std::fixed << std::setprecision(1) << change << '%'
+					  << std::defaultfloat;
+
+			if(change < -(r.second.timed ? tolerance : CountTolerance))
+			{
+				std::cout << "  REGRESSION";
+				++regressions;
+			}
+		}
+
+		//a metric at zero in the baseline, such as allocations per cycle,
+		//regresses on any growth
+		else if(b != base.end() && b->second == 0 && r.second.value > 0)
+		{
+			std::cout << std::setw(11) << "new" << "  REGRESSION";
+			++regressions;
+		}
+
+		std::cout << '\n';
+	}
+
+	if(output)
+		writeJson(output, results);
+
+	return regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}
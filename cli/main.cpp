@@ -0,0 +1,508 @@
+#include "src/VirtualMachine.hpp"
+#include "src/Assembler.hpp"
+#include "src/WarriorArchive.hpp"
+#include "src/AssemblyCache.hpp"
+#include "src/BulkAssembler.hpp"
+#include "src/ObjectFile.hpp"
+#include "src/Heatmap.hpp"
+
+#include <iostream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <limits>
+#include <cstdlib>
+#include <cctype>
+
+namespace
+{
+
+//the standard core the matches are played on
+const unsigned int CoreSize = 8000;
+
+//ICWS'94 MINDISTANCE
+const unsigned int MinDistance = 100;
+
+struct Options
+{
+	std::string p1;
+	std::string p2;
+
+	unsigned int rounds = 1;
+	unsigned int seed = 0;
+
+	//placement of player 2, random within MinDistance of player 1 if not given
+	bool fixedOffset = false;
+	unsigned int offset = 0;
+
+	VirtualMachine::Engine engine = VirtualMachine::SWITCH;
+
+	//dump a ProfileReport of both players after every round
+	bool profile = false;
+
+	//CSV file for the access counts of every cell, summed over the rounds
+	std::string heatmap;
+
+	//warriors are members of this archive instead of source files
+	std::string archive;
+
+	//directory of the AssemblyCache, sources are always assembled if empty
+	std::string cache;
+
+	//assemble the given sources into this archive and/or object
+	//directory instead of playing
+	std::string build;
+	std::string objects;
+	std::vector<std::string> sources;
+
+	//0 for one per hardware thread
+	unsigned int threads = 0;
+};
+
+//assembled source, or a member of an archive mapped for the whole match
+struct Warrior
+{
+	std::vector<VirtualMachine::Core::Instruction> instructions;
+
+	//loaded in place instead of instructions when set
+	const ObjectFile* object = nullptr;
+};
+
+void usage(const char* name)
+{
+	std::cerr << "usage: " << name << " [-r rounds] [-s seed] [-o offset] [-e switch|predecoded] [-p | -m heatmap.csv]"
+			  << " [-a archive | -k cachedir] warrior1 warrior2\n"
+			  << "       " << name << " [-k cachedir] [-j threads] [-c archive] [-d objdir] source...\n"
+				 "\n"
+				 "Plays the two warriors on the standard 8000 cell core and prints one\n"
+				 "tab-separated line per round: round, offset of player 2, result,\n"
+				 "cycles and the process counts of both players. Player 2 starts -o\n"
+				 "cells after player 1, from 100 to 7900, or at a random such offset.\n"
+				 "With -p the executed paths of both players are dumped to stderr after\n"
+				 "every round.\n"
+				 "With -m the executions, reads and writes of every cell by both players,\n"
+				 "summed over the rounds, are written to the given CSV file.\n"
+				 "With -a the warriors are names of members of the archive, otherwise\n"
+				 "they are source files. With -k assembled sources are cached in the\n"
+				 "given existing directory.\n"
+				 "\n"
+				 "With -c or -d the sources are assembled in parallel instead, into a\n"
+				 "warrior archive and/or one object file per source in the given existing\n"
+				 "directory. A source directory stands for the .red files in it. Members\n"
+				 "and objects are named after their file without the directory and the\n"
+				 "extension. Nothing is written unless every source assembles.\n";
+}
+
+unsigned int toUnsigned(const std::string& arg)
+{
+	//stoul would skip leading spaces and wrap a leading minus around
+	if(arg.empty() || !std::isdigit(static_cast<unsigned char>(arg[0])))
+		throw std::invalid_argument("Not a number: " + arg);
+
+	std::size_t end;
+
+	unsigned long value = std::stoul(arg, &end);
+
+	if(end != arg.size())
+		throw std::invalid_argument("Not a number: " + arg);
+
+	if(value > std::numeric_limits<unsigned int>::max())
+		throw std::out_of_range("Out of range: " + arg);
+
+	return static_cast<unsigned int>(value);
+}
+
+Options parse(int argc, char** argv)
+{
+	Options opt;
+	std::vector<std::string> files;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if(arg == "-p")
+			opt.profile = true;
+
+		else if(arg.size() == 2 && arg[0] == '-')
+		{
+			if(i + 1 == argc)
+				throw std::invalid_argument("Missing value for " + arg);
+
+			std::string value = argv[++i];
+
+			switch(arg[1])
+			{
+			case 'r':
+				opt.rounds = toUnsigned(value);
+				break;
+
+			case 's':
+				opt.seed = toUnsigned(value);
+				break;
+
+			case 'o':
+				opt.offset = toUnsigned(value);
+				opt.fixedOffset = true;
+
+				//closer than MinDistance to player 1 on either side of the core
+				if(opt.offset < MinDistance || opt.offset > CoreSize - MinDistance)
+					throw std::invalid_argument("Offset must be between " + std::to_string(MinDistance) +
+												" and " + std::to_string(CoreSize - MinDistance));
+				break;
+
+			case 'a':
+				opt.archive = value;
+				break;
+
+			case 'c':
+				opt.build = value;
+				break;
+
+			case 'k':
+				opt.cache = value;
+				break;
+
+			case 'm':
+				opt.heatmap = value;
+				break;
+
+			case 'd':
+				opt.objects = value;
+				break;
+
+			case 'j':
+				opt.threads = toUnsigned(value);
+				break;
+
+			case 'e':
+				if(value == "switch")
+					opt.engine = VirtualMachine::SWITCH;
+				else if(value == "predecoded")
+					opt.engine = VirtualMachine::PREDECODED;
+				else
+					throw std::invalid_argument("Unknown engine: " + value);
+				break;
+
+			default:
+				throw std::invalid_argument("Unknown option: " + arg);
+			}
+		}
+
+		else
+			files.push_back(arg);
+	}
+
+	if(!opt.build.empty() || !opt.objects.empty())
+	{
+		if(files.empty())
+			throw std::invalid_argument("Expected sources to assemble");
+
+		opt.sources = files;
+
+		return opt;
+	}
+
+	if(files.size() != 2)
+		throw std::invalid_argument("Expected two warriors");
+
+	if(opt.profile && !opt.heatmap.empty())
+		throw std::invalid_argument("-p and -m cannot be combined");
+
+	opt.p1 = files[0];
+	opt.p2 = files[1];
+
+	return opt;
+}
+
+bool assemble(const Options& opt, const std::string& fname, Warrior& out)
+{
+	Assembler::Result res;
+
+	if(opt.cache.empty())
+		res = Assembler().assembleFile(fname.c_str());
+	else
+		res = AssemblyCache(opt.cache).assembleFile(fname.c_str());
+
+	for(const auto& d : res.diagnostics)
+		std::cerr << fname << ':' << d.line << ": " << d.message << '\n';
+
+	out.instructions = std::move(res.instructions);
+
+	return res.success;
+}
+
+bool load(const WarriorArchive& archive, const std::string& name, Warrior& out)
+{
+	int i = archive.find(name);
+
+	if(i == WarriorArchive::NotFound)
+	{
+		std::cerr << "No warrior named " << name << " in archive\n";
+
+		return false;
+	}
+
+	out.object = &archive[i];
+
+	return true;
+}
+
+std::string memberName(const std::string& fname)
+{
+	std::size_t begin = fname.find_last_of("/\\");
+
+	begin = begin == std::string::npos ? 0 : begin + 1;
+
+	std::size_t end = fname.rfind('.');
+
+	if(end == std::string::npos || end < begin)
+		end = fname.size();
+
+	return fname.substr(begin, end - begin);
+}
+
+int build(const Options& opt)
+{
+	std::vector<std::string> files;
+
+	std::vector<WarriorArchive::Member> members;
+
+	try
+	{
+		for(const auto& source : opt.sources)
+		{
+			if(!std::filesystem::is_directory(source))
+				files.push_back(source);
+
+			else
+				for(auto& fname : BulkAssembler::listSources(source))
+					files.push_back(std::move(fname));
+		}
+
+		unsigned int threads = opt.threads ? opt.threads : std::thread::hardware_concurrency();
+
+		BulkAssembler bulk(CoreSize, threads);
+
+		bulk.setCache(opt.cache);
+
+		unsigned int failed = 0;
+
+		//every file has finished, so its diagnostics are printed in one piece
+		for(auto& unit : bulk.assemble(files))
+		{
+			for(const auto& d : unit.result.diagnostics)
+				std::cerr << unit.fname << ':' << d.line << ": " << d.message << '\n';
+
+			if(!unit.result.success)
+				++failed;
+
+			members.push_back(WarriorArchive::Member{memberName(unit.fname), std::move(unit.result.instructions)});
+		}
+
+		if(failed)
+		{
+			std::cerr << failed << " of " << files.size() << " sources failed to assemble\n";
+
+			return 2;
+		}
+
+		if(!opt.build.empty())
+			WarriorArchive::write(opt.build.c_str(), members);
+
+		if(!opt.objects.empty())
+			for(const auto& m : members)
+				ObjectFile::write((opt.objects + '/' + m.name + ".cwo").c_str(), m.instructions);
+	}
+
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << '\n';
+
+		return EXIT_FAILURE;
+	}
+
+	std::cerr << "assembled " << files.size() << " sources\n";
+
+	return EXIT_SUCCESS;
+}
+
+const char* toString(VirtualMachine::RoundState state)
+{
+	switch(state)
+	{
+	case VirtualMachine::P1_WON:
+		return "P1_WON";
+
+	case VirtualMachine::P2_WON:
+		return "P2_WON";
+
+	case VirtualMachine::DRAW:
+		return "DRAW";
+
+	default:
+		return "ONGOING";
+	}
+}
+
+void dumpProfile(HeadlessVirtualMachine&, unsigned int) {}
+
+void dumpProfile(HeatmappedVirtualMachine&, unsigned int) {}
+
+void dumpProfile(ProfiledVirtualMachine& vm, unsigned int round)
+{
+	std::cerr << "# round " << round << " player 1\n" << vm.getP1Report().toString()
+			  << "# round " << round << " player 2\n" << vm.getP2Report().toString();
+
+	vm.getP1Report().reset();
+	vm.getP2Report().reset();
+}
+
+//only a HeatmapReport counts the accesses
+template<class VM>
+void writeHeatmap(VM&, const Options&) {}
+
+void writeHeatmap(HeatmappedVirtualMachine& vm, const Options& opt)
+{
+	Heatmap::writeCsv(opt.heatmap.c_str(), vm.getP1Report().getHeatmap(), vm.getP2Report().getHeatmap());
+}
+
+template<class VM>
+void load(VM& vm, const Warrior& w, unsigned int offset, bool isP1)
+{
+	if(w.object)
+		vm.loadProgram(*w.object, offset, isP1);
+	else
+		vm.loadProgram(w.instructions, offset, isP1);
+}
+
+template<class VM>
+int play(const Options& opt, const Warrior& p1, const Warrior& p2)
+{
+	std::unique_ptr<VM> vm(new VM(CoreSize, opt.engine));
+
+	unsigned int wins[3] = {0, 0, 0};
+
+	std::cout << "round\toffset\tresult\tcycles\tp1_processes\tp2_processes\n";
+
+	for(unsigned int round = 0; round < opt.rounds; ++round)
+	{
+		unsigned int offset = opt.offset;
+
+		if(!opt.fixedOffset)
+		{
+			std::seed_seq seq = {opt.seed, round};
+			std::mt19937 rng(seq);
+
+			offset = MinDistance + rng() % (vm->getCoreSize() - 2 * MinDistance + 1);
+		}
+
+		VirtualMachine::MatchResult res;
+
+		try
+		{
+			vm->reset();
+			load(*vm, p1, 0, true);
+			load(*vm, p2, offset, false);
+
+			res = vm->runToCompletion();
+		}
+
+		catch(const std::exception& e)
+		{
+			std::cerr << e.what() << '\n';
+
+			return EXIT_FAILURE;
+		}
+
+		std::cout << round << '\t' << offset << '\t' << toString(res.state) << '\t'
+				  << res.cycles << '\t' << res.p1Processes << '\t' << res.p2Processes << '\n';
+
+		dumpProfile(*vm, round);
+
+		if(res.state == VirtualMachine::P1_WON)
+			++wins[0];
+		else if(res.state == VirtualMachine::P2_WON)
+			++wins[1];
+		else
+			++wins[2];
+	}
+
+	std::cerr << "P1 " << wins[0] << " P2 " << wins[1] << " DRAW " << wins[2] << '\n';
+
+	try
+	{
+		writeHeatmap(*vm, opt);
+	}
+
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << '\n';
+
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+
+	try
+	{
+		opt = parse(argc, argv);
+	}
+
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << '\n';
+		usage(argv[0]);
+
+		return EXIT_FAILURE;
+	}
+
+	if(!opt.build.empty() || !opt.objects.empty())
+		return build(opt);
+
+	Warrior p1, p2;
+
+	//members are played straight from the mapping
+	std::unique_ptr<WarriorArchive> archive;
+
+	if(!opt.archive.empty())
+	{
+		try
+		{
+			archive.reset(new WarriorArchive(opt.archive.c_str()));
+		}
+
+		catch(const std::exception& e)
+		{
+			std::cerr << e.what() << '\n';
+
+			return EXIT_FAILURE;
+		}
+
+		if(!load(*archive, opt.p1, p1) || !load(*archive, opt.p2, p2))
+			return 2;
+	}
+
+	else if(!assemble(opt, opt.p1, p1) || !assemble(opt, opt.p2, p2))
+		return 2;
+
+	if(opt.profile)
+		return play<ProfiledVirtualMachine>(opt, p1, p2);
+
+	if(!opt.heatmap.empty())
+		return play<HeatmappedVirtualMachine>(opt, p1, p2);
+
+	return play<HeadlessVirtualMachine>(opt, p1, p2);
+}
@@ -0,0 +1,211 @@
+#include "coreview.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+const unsigned int Columns = 100;
+
+//every cell is a block of BlockPixels with a gap up to CellPixels
+const int CellPixels = 3;
+const int BlockPixels = 2;
+
+//~60 Hz
+const int FrameInterval = 16;
+
+}
+
+CoreView::CoreView(QWidget *parent) :
+	QWidget(parent),
+	frameTimer_(new QTimer(this)),
+	coreSize_(0)
+{
+	setAttribute(Qt::WA_OpaquePaintEvent);
+
+	frameTimer_->setSingleShot(true);
+	frameTimer_->setInterval(FrameInterval);
+
+	connect(frameTimer_, SIGNAL(timeout()), this, SLOT(flush()));
+
+	setCoreSize(8000);
+}
+
+void CoreView::setCoreSize(unsigned int size)
+{
+	coreSize_ = size;
+
+	image_ = QImage(Columns * CellPixels, (size + Columns - 1) / Columns * CellPixels, QImage::Format_RGB32);
+
+	clear();
+
+	//the layout asks for the hints again
+	updateGeometry();
+}
+
+void CoreView::setCell(unsigned int adr, QRgb color)
+{
+	if(adr >= coreSize_)
+		return;
+
+	QRect block(adr % Columns * CellPixels, adr / Columns * CellPixels, BlockPixels, BlockPixels);
+
+	for(int y = block.top(); y <= block.bottom(); ++y)
+	{
+		QRgb* line = reinterpret_cast<QRgb*>(image_.scanLine(y));
+
+		std::fill(line + block.left(), line + block.right() + 1, color);
+	}
+
+	dirty_ |= block;
+
+	if(!frameTimer_->isActive())
+		frameTimer_->start();
+}
+
+void CoreView::clear()
+{
+	image_.fill(Qt::black);
+
+	dirty_ = QRect();
+	message_.clear();
+	overlay_ = QImage();
+
+	update();
+}
+
+void CoreView::setMessage(const QString& message)
+{
+	message_ = message;
+
+	update();
+}
+
+void CoreView::setOverlay(const QImage& overlay)
+{
+	overlay_ = overlay;
+
+	update();
+}
+
+QImage CoreView::renderHeatmap(const Heatmap& p1, const Heatmap& p2)
+{
+	unsigned int size = std::min(p1.getSize(), p2.getSize());
+
+	QImage image(Columns, (size + Columns - 1) / Columns, QImage::Format_RGB32);
+
+	image.fill(Qt::black);
+
+	//red, green and blue
+	const Heatmap::Access channels[] = {Heatmap::WRITE, Heatmap::READ, Heatmap::EXEC};
+
+	std::vector<int> levels[3];
+
+	for(int c = 0; c < 3; ++c)
+	{
+		std::vector<unsigned int> sum(size);
+
+		for(unsigned int adr = 0; adr < size; ++adr)
+			sum[adr] = p1.get(channels[c], adr) + p2.get(channels[c], adr);
+
+		unsigned int max = size ? *std::max_element(sum.begin(), sum.end()) : 0;
+
+		double scale = max ? 255 / std::log1p(max) : 0;
+
+		levels[c].resize(size);
+
+		for(unsigned int adr = 0; adr < size; ++adr)
+			levels[c][adr] = std::lround(std::log1p(sum[adr]) * scale);
+	}
+
+	for(unsigned int adr = 0; adr < size; ++adr)
+		image.setPixel(adr % Columns, adr / Columns, qRgb(levels[0][adr], levels[1][adr], levels[2][adr]));
+
+	return image;
+}
+
+QSize CoreView::sizeHint() const
+{
+	return image_.size();
+}
+
+QSize CoreView::minimumSizeHint() const
+{
+	return QSize(Columns, (coreSize_ + Columns - 1) / Columns);
+}
+
+void CoreView::paintEvent(QPaintEvent *event)
+{
+	QPainter painter(this);
+
+	painter.fillRect(event->rect(), Qt::black);
+
+	QRect source = toImage(event->rect());
+
+	if(!source.isEmpty())
+		painter.drawImage(toWidget(source), image_, source);
+
+	//black adds nothing, so untouched cells show through
+	if(!overlay_.isNull())
+	{
+		painter.setCompositionMode(QPainter::CompositionMode_Plus);
+		painter.drawImage(toWidget(image_.rect()), overlay_);
+		painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+	}
+
+	if(!message_.isEmpty())
+	{
+		QRect box = painter.fontMetrics().boundingRect(message_).adjusted(-4, -2, 4, 2);
+
+		box.moveCenter(rect().center());
+
+		painter.setPen(Qt::red);
+		painter.setBrush(Qt::black);
+		painter.drawRect(box);
+
+		painter.setPen(Qt::white);
+		painter.drawText(box, Qt::AlignCenter, message_);
+	}
+}
+
+void CoreView::flush()
+{
+	if(dirty_.isNull())
+		return;
+
+	//scaled blocks may bleed into the neighbouring pixels
+	update(toWidget(dirty_).toAlignedRect().adjusted(-1, -1, 1, 1));
+
+	dirty_ = QRect();
+}
+
+QRect CoreView::toImage(const QRect& r) const
+{
+	QRectF frame = toWidget(image_.rect());
+
+	qreal scale = frame.width() / image_.width();
+
+	if(scale <= 0)
+		return QRect();
+
+	QRectF source((r.x() - frame.x()) / scale, (r.y() - frame.y()) / scale,
+				  r.width() / scale, r.height() / scale);
+
+	return source.toAlignedRect() & image_.rect();
+}
+
+QRectF CoreView::toWidget(const QRect& r) const
+{
+	//whole image scaled to fit and centered, as fitInView did
+	qreal scale = std::min(qreal(width()) / image_.width(), qreal(height()) / image_.height());
+
+	qreal x = (width() - image_.width() * scale) / 2;
+	qreal y = (height() - image_.height() * scale) / 2;
+
+	return QRectF(x + r.x() * scale, y + r.y() * scale, r.width() * scale, r.height() * scale);
+}
@@ -0,0 +1,95 @@
+#ifndef COREVIEW_H
+#define COREVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <QTimer>
+
+#include "src/Heatmap.hpp"
+
+/*!
+ * \brief Core drawn as a framebuffer, one pixel block per cell
+ *
+ * setCell() only paints the block into the image and grows the dirty
+ * rectangle; at most once per frame that rectangle is scheduled for a
+ * repaint, which copies just the dirty part of the image to the screen.
+ * Cost per frame is therefore proportional to the cells changed, not to
+ * the length of the match.
+ */
+class CoreView : public QWidget
+{
+	Q_OBJECT
+
+public:
+	explicit CoreView(QWidget *parent = 0);
+
+	void setCoreSize(unsigned int);
+
+	void setCell(unsigned int, QRgb);
+
+	/*!
+	 * \brief Blanks every cell and removes the message
+	 */
+	void clear();
+
+	/*!
+	 * \brief Text boxed in the middle of the view, none if empty
+	 */
+	void setMessage(const QString&);
+
+	/*!
+	 * \brief Image added on top of the cells, one pixel per cell, none if null
+	 */
+	void setOverlay(const QImage&);
+
+	/*!
+	 * \brief One pixel per cell, writes in red, reads in green and executions in blue
+	 *
+	 * Counts of both players are summed and scaled logarithmically to the
+	 * hottest cell, so a cell nobody touched stays black.
+	 */
+	static QImage renderHeatmap(const Heatmap&, const Heatmap&);
+
+	/*!
+	 * \brief Whole core at the native block size
+	 */
+	QSize sizeHint() const;
+
+	/*!
+	 * \brief Whole core at one pixel per cell
+	 */
+	QSize minimumSizeHint() const;
+
+protected:
+
+	void paintEvent(QPaintEvent*);
+
+private slots:
+
+	void flush();
+
+private:
+
+	//image rectangle shown in the given widget rectangle and vice versa
+	QRect toImage(const QRect&) const;
+	QRectF toWidget(const QRect&) const;
+
+	QImage image_;
+
+	QImage overlay_;
+
+	//part of image_ changed since the last frame, in image coordinates
+	QRect dirty_;
+
+	QTimer* frameTimer_;
+
+	QString message_;
+
+	unsigned int coreSize_;
+};
+
+#endif // COREVIEW_H
@@ -0,0 +1,92 @@
+#include "logmodel.h"
+
+#include <algorithm>
+
+namespace
+{
+
+//rows kept per player
+const std::size_t Capacity = 10000;
+
+}
+
+LogModel::LogModel(QObject *parent) :
+	QAbstractListModel(parent),
+	log_(Capacity),
+	dropped_(0)
+{
+}
+
+int LogModel::rowCount(const QModelIndex& parent) const
+{
+	if(parent.isValid())
+		return 0;
+
+	return log_.size() - dropped_ + !message_.isEmpty();
+}
+
+QVariant LogModel::data(const QModelIndex& index, int role) const
+{
+	if(!index.isValid() || role != Qt::DisplayRole)
+		return QVariant();
+
+	std::size_t row = index.row();
+
+	if(!message_.isEmpty())
+	{
+		if(!row)
+			return message_;
+
+		--row;
+	}
+
+	row += dropped_;
+
+	if(row >= log_.size())
+		return QVariant();
+
+	return QString::fromStdString(InstructionLog::format(log_[row]));
+}
+
+void LogModel::append(const InstructionLog& log)
+{
+	std::size_t added = std::min(log.size(), log_.capacity());
+
+	if(!added)
+		return;
+
+	int first = !message_.isEmpty();
+
+	//the oldest rows leave before the new ones arrive, so a full ring
+	//does not cost the views their scroll position and selection
+	std::size_t kept = log_.capacity() - added;
+
+	if(log_.size() > kept)
+	{
+		beginRemoveRows(QModelIndex(), first, first + (log_.size() - kept) - 1);
+		dropped_ = log_.size() - kept;
+		endRemoveRows();
+	}
+
+	int last = rowCount();
+
+	beginInsertRows(QModelIndex(), last, last + added - 1);
+	log_.append(log);
+	dropped_ = 0;
+	endInsertRows();
+}
+
+void LogModel::setMessage(const QString& message)
+{
+	beginResetModel();
+	message_ = message;
+	endResetModel();
+}
+
+void LogModel::clear()
+{
+	beginResetModel();
+	log_.clear();
+	message_.clear();
+	endResetModel();
+}
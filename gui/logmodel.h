@@ -0,0 +1,44 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include "src/InstructionLog.hpp"
+
+#include <QAbstractListModel>
+#include <QString>
+
+/*!
+ * \brief Player log pane backed by an InstructionLog
+ *
+ * Only the newest entries are kept, and a row is formatted only when a
+ * view asks for it, so a long match costs neither memory nor the time to
+ * lay out text for lines nobody scrolls to. A plain message, such as the
+ * load notice, is shown above the entries.
+ */
+class LogModel : public QAbstractListModel
+{
+	Q_OBJECT
+
+public:
+	explicit LogModel(QObject *parent = 0);
+
+	int rowCount(const QModelIndex& parent = QModelIndex()) const;
+
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+	void append(const InstructionLog&);
+
+	void setMessage(const QString&);
+
+	void clear();
+
+private:
+
+	InstructionLog log_;
+
+	//oldest entries already removed from the rows, still in the ring
+	std::size_t dropped_;
+
+	QString message_;
+};
+
+#endif // LOGMODEL_H
@@ -4,54 +4,103 @@
 #include "src/Assembler.hpp"
 
 #include <cstdlib>
+#include <chrono>
 
 #include <iostream>
 
+#include <QDir>
 #include <QFileDialog>
-#include <QGraphicsItem>
 #include <QMessageBox>
+#include <QScrollBar>
+#include <QStandardPaths>
+
+namespace
+{
+
+//~60 Hz
+const int FrameInterval = 16;
+
+//per-user cache location, created if missing
+std::string cacheDirectory()
+{
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/warriors";
+
+	QDir().mkpath(dir);
+
+	return dir.toStdString();
+}
+
+}
 
 MainWindow::MainWindow(QWidget *parent) :
 	QMainWindow(parent),
 	ui(new Ui::MainWindow),
-	maxSpeed_(true)
+	cache_(cacheDirectory()),
+	p1LogModel_(new LogModel(this)),
+	p2LogModel_(new LogModel(this))
 {
 	ui->setupUi(this);
 
+	ui->p1Log->setModel(p1LogModel_);
+	ui->p2Log->setModel(p2LogModel_);
+
 	srand(time(NULL));
 
+	//the match runs on runner_'s worker, this only picks up its frames
 	timer = new QTimer(this);
+	timer->setInterval(FrameInterval);
 
-	connect(timer, SIGNAL(timeout()), this, SLOT(doStep()));
+	connect(timer, SIGNAL(timeout()), this, SLOT(showFrame()));
 
 	ui->runButton->setEnabled(false);
 	ui->stopButton->setEnabled(false);
 	ui->stepButton->setEnabled(false);
 
-	scene = new QGraphicsScene(0, 0, 299, 239, this);
-
-	scene->setBackgroundBrush(QBrush(Qt::black));
-
-	ui->graphicsView->setScene(scene);
+	ui->coreView->setCoreSize(runner_.getCoreSize());
 }
 
 MainWindow::~MainWindow()
 {
 	delete timer;
-	delete scene;
 	delete ui;
 }
 
-void MainWindow::resizeEvent(QResizeEvent *event)
+void MainWindow::showHeatmap()
+{
+	runner_.copyHeatmaps(p1Heat_, p2Heat_);
+
+	ui->coreView->setOverlay(CoreView::renderHeatmap(p1Heat_, p2Heat_));
+}
+
+bool MainWindow::assemble(const std::string& fname, std::vector<VirtualMachine::Core::Instruction>& program)
 {
-	ui->graphicsView->fitInView(scene->sceneRect());
+	Assembler::Result res = cache_.assembleFile(fname.c_str());
+
+	for(const auto& d : res.diagnostics)
+		std::cerr << fname << ':' << d.line << ": " << d.message << std::endl;
+
+	if(!res.success)
+	{
+		QMessageBox::warning(this, tr("Compilation Error"), tr("Selected file was assembled with errors!"));
+
+		return false;
+	}
 
-	QMainWindow::resizeEvent(event);
+	program = std::move(res.instructions);
+
+	return true;
 }
 
-void MainWindow::showEvent(QShowEvent *)
+void MainWindow::appendLog(QListView* view, LogModel* model, const InstructionLog& log)
 {
-	ui->graphicsView->fitInView(scene->sceneRect());
+	QScrollBar* bar = view->verticalScrollBar();
+
+	bool atEnd = bar->value() == bar->maximum();
+
+	model->append(log);
+
+	if(atEnd)
+		view->scrollToBottom();
 }
 
 void MainWindow::on_actionAssemble_And_Load_Player_1_triggered()
@@ -61,29 +110,25 @@ void MainWindow::on_actionAssemble_And_Load_Player_1_triggered()
 	if(fname.empty())
 		return;
 
-	Assembler::getInstance().openFile(fname.c_str());
-
-	if(!Assembler::getInstance().assembly())
-	{
-		QMessageBox::warning(this, tr("Compilation Error"), tr("Selected file was assembled with errors!"));
+	std::vector<VirtualMachine::Core::Instruction> program;
 
+	if(!assemble(fname, program))
 		return;
-	}
 
-	if(vm_.isLoadedP2())
+	if(runner_.isLoadedP2())
 	{
-		p1Pos_ = p2Pos_ + rand() % (vm_.getCoreSize() - 2000) + 1000;
+		p1Pos_ = p2Pos_ + rand() % (runner_.getCoreSize() - 2000) + 1000;
 
 		ui->runButton->setEnabled(true);
 		ui->stepButton->setEnabled(true);
 	}
 
 	else
-		p1Pos_ = rand() % vm_.getCoreSize();
+		p1Pos_ = rand() % runner_.getCoreSize();
 
-	vm_.loadProgram(Assembler::getInstance().getInstructions(), p1Pos_);
+	runner_.load(program, p1Pos_);
 
-	ui->p1Log->appendPlainText(tr("Program loaded."));
+	p1LogModel_->setMessage(tr("Program loaded."));
 
 	ui->p1ProcessesBar->setValue(1);
 
@@ -97,29 +142,25 @@ void MainWindow::on_actionAssemble_And_Load_Player_2_triggered()
 	if(fname.empty())
 		return;
 
-	Assembler::getInstance().openFile(fname.c_str());
-
-	if(!Assembler::getInstance().assembly())
-	{
-		QMessageBox::warning(this, tr("Compilation Error"), tr("Selected file was assembled with errors!"));
+	std::vector<VirtualMachine::Core::Instruction> program;
 
+	if(!assemble(fname, program))
 		return;
-	}
 
-	if(vm_.isLoadedP1())
+	if(runner_.isLoadedP1())
 	{
-		p2Pos_ = p1Pos_ + rand() % (vm_.getCoreSize() - 2000) + 1000;
+		p2Pos_ = p1Pos_ + rand() % (runner_.getCoreSize() - 2000) + 1000;
 
 		ui->runButton->setEnabled(true);
 		ui->stepButton->setEnabled(true);
 	}
 
 	else
-		p2Pos_ = rand() % vm_.getCoreSize();
+		p2Pos_ = rand() % runner_.getCoreSize();
 
-	vm_.loadProgram(Assembler::getInstance().getInstructions(), p2Pos_, false);
+	runner_.load(program, p2Pos_, false);
 
-	ui->p2Log->appendPlainText(tr("Program loaded."));
+	p2LogModel_->setMessage(tr("Program loaded."));
 
 	ui->p2ProcessesBar->setValue(1);
 
@@ -133,18 +174,21 @@ void MainWindow::on_actionExit_triggered()
 
 void MainWindow::on_stepButton_clicked()
 {
-	doStep();
+	runner_.step();
+
+	timer->start();
 }
 
 void MainWindow::on_actionReset_triggered()
 {
-	if(timer->isActive())
-		timer->stop();
+	timer->stop();
+
+	runner_.reset();
 
-	scene->clear();
+	ui->coreView->clear();
 
-	ui->p1Log->clear();
-	ui->p2Log->clear();
+	p1LogModel_->clear();
+	p2LogModel_->clear();
 
 	ui->p1ProcessesBar->setValue(0);
 	ui->p2ProcessesBar->setValue(0);
@@ -155,8 +199,6 @@ void MainWindow::on_actionReset_triggered()
 
 	ui->actionAssemble_And_Load_Player_1->setEnabled(true);
 	ui->actionAssemble_And_Load_Player_2->setEnabled(true);
-
-	vm_.reset();
 }
 
 void MainWindow::on_runButton_clicked()
@@ -165,6 +207,8 @@ void MainWindow::on_runButton_clicked()
 	ui->stopButton->setEnabled(true);
 	ui->stepButton->setEnabled(false);
 
+	runner_.start();
+
 	timer->start();
 }
 
@@ -174,137 +218,97 @@ void MainWindow::on_stopButton_clicked()
 	ui->stopButton->setEnabled(false);
 	ui->stepButton->setEnabled(true);
 
-	timer->stop();
+	runner_.stop();
 }
 
 
-void MainWindow::doStep()
+void MainWindow::showFrame()
 {
-	VirtualMachine::StatReport rep;
-	QGraphicsRectItem* p;
-	QList<QGraphicsItem*> list;
-
-	vm_.executeCycle();
+	MatchRunner::Frame frame = runner_.takeFrame();
 
-	rep = vm_.getP1Report();
+	for(auto adr : frame.p1Writes)
+		ui->coreView->setCell(adr, QColor(Qt::magenta).rgb());
 
-	ui->p1ProcessesBar->setValue(rep.getProcessCount());
+	for(auto adr : frame.p2Writes)
+		ui->coreView->setCell(adr, QColor(Qt::yellow).rgb());
 
-	if( (!maxSpeed_ && timer->isActive()) || !timer->isActive() )
-		ui->p1Log->appendPlainText(QString::fromStdString(rep.toString()));
+	appendLog(ui->p1Log, p1LogModel_, frame.p1Log);
+	appendLog(ui->p2Log, p2LogModel_, frame.p2Log);
 
-	//p = scene->addRect(3 * (rep.getExecutedAdr() % 100), 3 * (rep.getExecutedAdr() / 100), 2, 2, QPen(Qt::NoPen), QBrush(Qt::cyan));
+	if(ui->actionShow_Heatmap->isChecked())
+		showHeatmap();
 
-	//list += scene->collidingItems(reinterpret_cast<QGraphicsItem*>(p));
+	ui->p1ProcessesBar->setValue(frame.result.p1Processes);
+	ui->p2ProcessesBar->setValue(frame.result.p2Processes);
 
-	p = scene->addRect(3 * (rep.getWriteAdr() % 100), 3 * (rep.getWriteAdr() / 100), 2, 2, QPen(Qt::NoPen), QBrush(Qt::magenta));
-
-	list += scene->collidingItems(reinterpret_cast<QGraphicsItem*>(p));
+	if(!frame.running)
+		timer->stop();
 
-	while(!list.isEmpty())
+	switch(frame.result.state)
 	{
-		QGraphicsItem* obj = list.last();
+		case VirtualMachine::ONGOING:
+			return;
 
-		scene->removeItem(obj);
-
-		delete obj;
-
-		list.removeLast();
-	}
+		case VirtualMachine::DRAW:
+			ui->coreView->setMessage("DRAW");
+			break;
 
-	if(VirtualMachine::StatReport::getState() != VirtualMachine::StatReport::ONGOING)
-	{
-		timer->stop();
+		case VirtualMachine::P1_WON:
+			ui->coreView->setMessage("PLAYER 1 WINS");
+			break;
 
-		ui->runButton->setEnabled(false);
-		ui->stopButton->setEnabled(false);
-		ui->stepButton->setEnabled(false);
+		case VirtualMachine::P2_WON:
+			ui->coreView->setMessage("PLAYER 2 WINS");
+			break;
 	}
 
-	rep = vm_.getP2Report();
-
-	ui->p2ProcessesBar->setValue(rep.getProcessCount());
-
-	if( (!maxSpeed_ && timer->isActive()) || !timer->isActive() )
-		ui->p2Log->appendPlainText(QString::fromStdString(rep.toString()));
-
-	//p = scene->addRect(3 * (rep.getExecutedAdr() % 100), 3 * (rep.getExecutedAdr() / 100), 2, 2, QPen(Qt::NoPen), QBrush(Qt::red));
-
-	//list += scene->collidingItems(reinterpret_cast<QGraphicsItem*>(p));
-
-	p = scene->addRect(3 * (rep.getWriteAdr() % 100), 3 * (rep.getWriteAdr() / 100), 2, 2, QPen(Qt::NoPen), QBrush(Qt::yellow));
-
-	list += scene->collidingItems(reinterpret_cast<QGraphicsItem*>(p));
-
-	while(!list.isEmpty())
-	{
-		QGraphicsItem* obj = list.last();
-
-		scene->removeItem(obj);
+	ui->runButton->setEnabled(false);
+	ui->stopButton->setEnabled(false);
+	ui->stepButton->setEnabled(false);
+}
 
-		delete obj;
+void MainWindow::on_speedSlider_valueChanged(int value)
+{
+	runner_.setInterval(std::chrono::milliseconds((ui->speedSlider->maximum() - value) * 75));
+}
 
-		list.removeLast();
-	}
+void MainWindow::on_actionShow_Heatmap_toggled(bool checked)
+{
+	if(checked)
+		showHeatmap();
 
-	bool isEnd = false;
+	else
+		ui->coreView->setOverlay(QImage());
+}
 
-	QGraphicsSimpleTextItem* tp;
-	QGraphicsRectItem* rp;
+void MainWindow::on_actionExport_Heatmap_triggered()
+{
+	QString fname = QFileDialog::getSaveFileName(this, tr("Export Heatmap"), QDir::homePath(),
+												 tr("CSV files (*.csv);;PNG images (*.png)"));
 
-	switch(VirtualMachine::StatReport::getState())
-	{
-		case VirtualMachine::StatReport::ONGOING:
-			break;
+	if(fname.isEmpty())
+		return;
 
-		case VirtualMachine::StatReport::DRAW:
-			tp = new QGraphicsSimpleTextItem(QString("DRAW"));
-			tp->setBrush(QBrush(Qt::white));
-			tp->setPos(scene->width() / 2 - tp->boundingRect().width() / 2, scene->height() / 2 - tp->boundingRect().height() / 2);
-			rp = scene->addRect(tp->boundingRect(), QPen(Qt::red), QBrush(Qt::black));
-			scene->addItem(tp);
-			rp->setTransform(tp->sceneTransform());
-			isEnd = true;
-			break;
+	runner_.copyHeatmaps(p1Heat_, p2Heat_);
 
-		case VirtualMachine::StatReport::P1_WON:
-			tp = new QGraphicsSimpleTextItem(QString("PLAYER 1 WINS"));
-			tp->setBrush(QBrush(Qt::white));
-			tp->setPos(scene->width() / 2 - tp->boundingRect().width() / 2, scene->height() / 2 - tp->boundingRect().height() / 2);
-			rp = scene->addRect(tp->boundingRect(), QPen(Qt::red), QBrush(Qt::black));
-			scene->addItem(tp);
-			rp->setTransform(tp->sceneTransform());
-			isEnd = true;
-			break;
+	bool saved = true;
 
-		case VirtualMachine::StatReport::P2_WON:
-			tp = new QGraphicsSimpleTextItem(QString("PLAYER 2 WINS"));
-			tp->setBrush(QBrush(Qt::white));
-			tp->setPos(scene->width() / 2 - tp->boundingRect().width() / 2, scene->height() / 2 - tp->boundingRect().height() / 2);
-			rp = scene->addRect(tp->boundingRect(), QPen(Qt::red), QBrush(Qt::black));
-			scene->addItem(tp);
-			rp->setTransform(tp->sceneTransform());
-			isEnd = true;
-			break;
-	}
+	if(fname.endsWith(".png", Qt::CaseInsensitive))
+		saved = CoreView::renderHeatmap(p1Heat_, p2Heat_).save(fname, "PNG");
 
-	if(isEnd && timer->isActive())
+	else
 	{
-		timer->stop();
-
-		ui->runButton->setEnabled(false);
-		ui->stopButton->setEnabled(false);
-		ui->stepButton->setEnabled(false);
+		try
+		{
+			Heatmap::writeCsv(fname.toStdString().c_str(), p1Heat_, p2Heat_);
+		}
+
+		catch(const std::exception&)
+		{
+			saved = false;
+		}
 	}
-}
 
-void MainWindow::on_speedSlider_valueChanged(int value)
-{
-	timer->setInterval((ui->speedSlider->maximum() - value) * 75);
-
-	if(value == ui->speedSlider->maximum())
-		maxSpeed_ = true;
-
-	else
-		maxSpeed_ = false;
+	if(!saved)
+		QMessageBox::warning(this, tr("Export Error"), tr("Heatmap could not be written!"));
 }
@@ -2,6 +2,9 @@
 #define MAINWINDOW_H
 
 #include "src/VirtualMachine.hpp"
+#include "src/MatchRunner.hpp"
+#include "src/AssemblyCache.hpp"
+#include "logmodel.h"
 
 #include <QMainWindow>
 #include <QTimer>
@@ -19,12 +22,6 @@ public:
 	explicit MainWindow(QWidget *parent = 0);
 	~MainWindow();
 
-protected:
-
-	void resizeEvent(QResizeEvent*);
-
-	void showEvent(QShowEvent*);
-
 private slots:
 	void on_actionAssemble_And_Load_Player_1_triggered();
 
@@ -40,21 +37,38 @@ private slots:
 
 	void on_stopButton_clicked();
 
-	void doStep();
+	void showFrame();
 
 	void on_speedSlider_valueChanged(int value);
 
+	void on_actionShow_Heatmap_toggled(bool checked);
+
+	void on_actionExport_Heatmap_triggered();
+
 private:
 
-	Ui::MainWindow *ui;
+	//keeps the newest rows in sight unless the user scrolled away
+	void appendLog(QListView*, LogModel*, const InstructionLog&);
 
-	QGraphicsScene* scene;
+	//latest counts of the runner drawn over the core
+	void showHeatmap();
+
+	//assembles the file, false after reporting the errors
+	bool assemble(const std::string&, std::vector<VirtualMachine::Core::Instruction>&);
+
+	Ui::MainWindow *ui;
 
 	QTimer* timer;
 
-	VirtualMachine vm_;
+	MatchRunner runner_;
+
+	AssemblyCache cache_;
+
+	LogModel* p1LogModel_;
+	LogModel* p2LogModel_;
 
-	bool maxSpeed_;
+	Heatmap p1Heat_;
+	Heatmap p2Heat_;
 
 	unsigned int p1Pos_;
 	unsigned int p2Pos_;
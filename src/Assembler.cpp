@@ -1,14 +1,138 @@
 #include "Assembler.hpp"
-
-#include "Tokenizer.hpp"
+#include "ObjectFile.hpp"
 
 #include <stdexcept>
 #include <algorithm>
 #include <string>
+#include <sstream>
+#include <fstream>
 #include <iostream>
+#include <climits>
+#include <cstdint>
 
 typedef VirtualMachine::Core::Instruction Instruction;
 
+namespace
+{
+
+//keywords packed into an integer, one byte per character
+constexpr std::uint32_t pack(std::string_view s)
+{
+	std::uint32_t key = 0;
+
+	for(char c : s)
+		key = key << 8 | static_cast<unsigned char>(c);
+
+	return key;
+}
+
+std::uint32_t packLower(std::string_view s)
+{
+	std::uint32_t key = 0;
+
+	for(char c : s)
+		key = key << 8 | static_cast<unsigned char>(Lexer::lower(c));
+
+	return key;
+}
+
+int opCode(std::string_view token)
+{
+	if(token.size() != 3)
+		return -1;
+
+	switch(packLower(token))
+	{
+	case pack("kil"): return Instruction::KIL;
+	case pack("frk"): return Instruction::FRK;
+	case pack("nop"): return Instruction::NOP;
+	case pack("mov"): return Instruction::MOV;
+	case pack("add"): return Instruction::ADD;
+	case pack("sub"): return Instruction::SUB;
+	case pack("mul"): return Instruction::MUL;
+	case pack("div"): return Instruction::DIV;
+	case pack("mod"): return Instruction::MOD;
+	case pack("jmp"): return Instruction::JMP;
+	case pack("jmz"): return Instruction::JMZ;
+	case pack("jmn"): return Instruction::JMN;
+	case pack("beq"): return Instruction::BEQ;
+	case pack("bne"): return Instruction::BNE;
+	case pack("blt"): return Instruction::BLT;
+	default: return -1;
+	}
+}
+
+int modifier(std::string_view token)
+{
+	if(token.empty() || token.size() > 2)
+		return -1;
+
+	switch(packLower(token))
+	{
+	case pack("a"): return Instruction::A;
+	case pack("b"): return Instruction::B;
+	case pack("ab"): return Instruction::AB;
+	case pack("ba"): return Instruction::BA;
+	case pack("f"): return Instruction::F;
+	case pack("x"): return Instruction::X;
+	case pack("i"): return Instruction::I;
+	default: return -1;
+	}
+}
+
+int addressMode(std::string_view token)
+{
+	if(token.size() != 1)
+		return -1;
+
+	switch(token[0])
+	{
+	case '#': return Instruction::IMM;
+	case '$': return Instruction::DIR;
+	case '*': return Instruction::AIN;
+	case '@': return Instruction::BIN;
+	default: return -1;
+	}
+}
+
+enum Number {NUMBER, PARTIAL_NUMBER, NOT_A_NUMBER, OUT_OF_RANGE};
+
+//accepts what std::stoi does: an optional sign followed by digits,
+//a token that goes on after the digits is only partially a number
+Number parseNumber(std::string_view token, int& value)
+{
+	std::size_t i = 0;
+	bool negative = false;
+
+	if(i < token.size() && (token[i] == '+' || token[i] == '-'))
+		negative = token[i++] == '-';
+
+	if(i == token.size() || token[i] < '0' || token[i] > '9')
+		return NOT_A_NUMBER;
+
+	long long n = 0;
+
+	for(; i < token.size() && token[i] >= '0' && token[i] <= '9'; ++i)
+	{
+		n = n * 10 + (token[i] - '0');
+
+		if(n > -static_cast<long long>(INT_MIN))
+			return OUT_OF_RANGE;
+	}
+
+	if(negative)
+		n = -n;
+
+	else if(n > INT_MAX)
+		return OUT_OF_RANGE;
+
+	value = static_cast<int>(n);
+
+	return i == token.size() ? NUMBER : PARTIAL_NUMBER;
+}
+
+}
+
 Assembler& Assembler::getInstance()
 {
 	static Assembler inst;
@@ -16,48 +140,103 @@ Assembler& Assembler::getInstance()
 	return inst;
 }
 
-Assembler::Assembler() : assembled_(false)
-{}
+Assembler::Assembler(unsigned int coreSize) : coreSize_(coreSize), assembled_(false)
+{
+	if(!coreSize_)
+		throw std::invalid_argument("Core size cannot be zero");
+}
 
-void Assembler::openFile(const char* fname)
+auto Assembler::assemble(const char* data, std::size_t size) const -> Result
 {
-	if(fin_.is_open())
+	Context ctx;
+
+	Lexer lex(" \t\r", ":.,#$*@");
+
+	bool success = true;
+	unsigned int lno = 0;
+
+	for(const char* end = data + size; data != end;)
 	{
-		fin_.close();
+		const char* eol = std::find(data, end, '\n');
 
-		instructionLines_.clear();
-		assembledInstructions_.clear();
+		std::string_view line(data, eol - data);
 
-		labels_.clear();
+		data = eol == end ? end : eol + 1;
 
-		fname_.clear();
+		++lno;
 
-		assembled_ = false;
-	}
+		//everything after ';' is a comment
+		lex.assign(line.substr(0, line.find(';')));
 
-	try
-	{
-		fin_.open(fname);
+		success &= readLine(lex, lno, ctx);
 	}
-	catch(const std::ifstream::failure& e)
+
+	success &= patchLabels(ctx);
+
+	ctx.result.success = success;
+
+	if(!ctx.result.success)
+		ctx.result.instructions.clear();
+
+	return std::move(ctx.result);
+}
+
+auto Assembler::assemble(const std::string& source) const -> Result
+{
+	return assemble(source.data(), source.size());
+}
+
+auto Assembler::assembleFile(const char* fname) const -> Result
+{
+	std::ifstream fin(fname, std::ifstream::in | std::ifstream::binary);
+
+	if(!fin)
 	{
-		std::cerr << e.what() << std::endl;
-		return;
+		Result res;
+
+		res.success = false;
+		res.diagnostics.push_back(Diagnostic{0, "Cannot open file"});
+
+		return res;
 	}
 
+	std::ostringstream buf;
+	buf << fin.rdbuf();
+
+	return assemble(buf.str());
+}
+
+unsigned int Assembler::getCoreSize() const
+{
+	return coreSize_;
+}
+
+void Assembler::openFile(const char* fname)
+{
+	assembledInstructions_.clear();
+
+	assembled_ = false;
+
 	fname_.assign(fname);
 }
 
 bool Assembler::assembly()
 {
-	if(!fin_.is_open())
+	if(fname_.empty())
 	{
 		std::cerr << "No file is open" << std::endl;
 
 		return false;
 	}
 
-	return assembled_ = readLabels() & readInstructions();
+	Result res = assembleFile(fname_.c_str());
+
+	for(const auto& d : res.diagnostics)
+		std::cerr << fname_ << ':' << d.line << ": " << d.message << std::endl;
+
+	assembledInstructions_ = std::move(res.instructions);
+
+	return assembled_ = res.success;
 }
 
 const std::vector<Instruction>& Assembler::getInstructions()
@@ -67,23 +246,10 @@ const std::vector<Instruction>& Assembler::getInstructions()
 
 void Assembler::toFile(const char* fname)
 {
-	//TODO EXCEPTION
 	if(!assembled_)
-		throw;
+		throw std::runtime_error("Nothing has been assembled");
 
-	std::ofstream fout(fname, std::ofstream::out |
-					   std::ofstream::binary |
-					   std::ofstream::trunc);
-
-	for(auto& ins : assembledInstructions_)
-	{
-		fout.write(reinterpret_cast<const char*>(&ins.op), sizeof(Instruction::OpCode));
-		fout.write(reinterpret_cast<const char*>(&ins.mod), sizeof(Instruction::Modifier));
-		fout.write(reinterpret_cast<const char*>(&ins.aMode), sizeof(Instruction::AddressMode));
-		fout.write(reinterpret_cast<const char*>(&ins.bMode), sizeof(Instruction::AddressMode));
-		fout.write(reinterpret_cast<const char*>(&ins.aVal), sizeof(unsigned int));
-		fout.write(reinterpret_cast<const char*>(&ins.bVal), sizeof(unsigned int));
-	}
+	ObjectFile::write(fname, assembledInstructions_, coreSize_);
 }
 
 bool Assembler::isAssembled()
@@ -91,532 +257,300 @@ bool Assembler::isAssembled()
 	return assembled_;
 }
 
-unsigned int Assembler::normalize(int n, unsigned int coresize)
+unsigned int Assembler::normalize(int n) const
 {
-	//TODO EXCEPTION
-	if(!coresize)
-		throw;
-
 	if(n < 0)
-		return static_cast<unsigned int>(coresize - (-n) % coresize);
+		return static_cast<unsigned int>((coreSize_ - (-n) % coreSize_) % coreSize_);
 
 	else
-		return static_cast<unsigned int>(n % coresize);
+		return static_cast<unsigned int>(n % coreSize_);
 }
 
-bool Assembler::readLabels()
+//a line holds an optional "label:" followed by an optional instruction
+bool Assembler::readLine(Lexer& lex, unsigned int lno, Context& ctx) const
 {
-	std::string line;
-	std::string label;
-	std::string fragment;
-
-	Tokenizer t(std::string(), " \t", ";:", true);
-
-	int ino = 0;
-	unsigned int lno = 0;
+	if(!lex.isToken())
+		return true;
 
 	bool success = true;
 
-	while( std::getline(fin_, line) )
+	std::string_view token = lex.next();
+
+	if(lex.isToken() && lex.peek() == ":")
 	{
-		std::string newline;
+		lex.next();
 
-		++lno;
+		if(!ctx.labels.define(ctx.labels.intern(token), ctx.index))
+		{
+			compilationError(ctx, "Label already present in file: \'" + std::string(token) + "\'", lno);
 
-		t.assign(line);
+			success = false;
+		}
 
-		if(!t.isToken())
-			continue;
+		if(!lex.isToken())
+			return success;
 
-		label = t.next();
+		token = lex.next();
+	}
 
-		if(label == ";")
-			continue;
+	success &= readInstruction(token, lex, lno, ctx);
 
-		if(!t.isToken())
-		{
-			instructionLines_.push_back(std::make_pair(lno, line));
+	++ctx.index;
 
-			++ino;
-			continue;
-		}
+	return success;
+}
 
-		//second token == ':'
-		if((fragment = t.next()) == ":")
-		{
-			if(labels_.count(label))
-			{
-				compilationError("Label already present in file: \'" + label + "\'", lno);
+bool Assembler::readInstruction(std::string_view token, Lexer& lex, unsigned int lno, Context& ctx) const
+{
+	Instruction ins;
 
-				success = false;
-			}
+	int op = opCode(token);
 
-			else
-				labels_[label] = ino;
+	if(op < 0)
+	{
+		compilationError(ctx, "Invalid instruction", lno);
 
-			if(t.isToken())
-			{
-				if( (fragment = t.next()) == ";")
-					continue;
+		return false;
+	}
 
-				else
-					newline = fragment + " ";
+	ins.op = static_cast<Instruction::OpCode>(op);
 
-				while(t.isToken())
-				{
-					if((fragment = t.next()) == ";")
-						break;
+	if(!lex.isToken())
+	{
+		compilationError(ctx, "No instruction arguments specified", lno);
 
-					newline += fragment + " ";
-				}
+		return false;
+	}
 
-				instructionLines_.push_back(std::make_pair(lno, newline));
+	bool defaultMod = lex.peek() != ".";
 
-				++ino;
-			}
-		}
-
-		//second token != ':'
-		else
+	if(defaultMod)
+	{
+		switch(ins.op)
 		{
-			newline = label + " ";
-
-			if(fragment != ";")
-			{
-				newline += fragment + " ";
-
-				while(t.isToken())
-				{
-					if((fragment = t.next()) == ";")
-						break;
+		case Instruction::OpCode::KIL:
+		case Instruction::OpCode::NOP:
+			ins.mod = Instruction::Modifier::F;
+			break;
+
+		case Instruction::OpCode::FRK:
+		case Instruction::OpCode::JMP:
+		case Instruction::OpCode::JMZ:
+		case Instruction::OpCode::JMN:
+			ins.mod = Instruction::Modifier::B;
+			break;
+
+		default:
+			break;
+		}
+	}
 
-					newline += fragment + " ";
-				}
-			}
+	else
+	{
+		lex.next();
 
-			instructionLines_.push_back(std::make_pair(lno, newline));
+		if(!lex.isToken())
+		{
+			compilationError(ctx, "Expected instruction modifier after \'.\'", lno);
 
-			++ino;
+			return false;
 		}
-	}//while
 
-	return success;
-}
+		int mod = modifier(lex.next());
 
-bool Assembler::readInstructions()
-{
-	static std::vector<std::string> op = {"kil", "frk", "nop", "mov", "add",
-										  "sub", "mul", "div", "mod", "jmp",
-										  "jmz", "jmn", "beq", "bne", "blt"};
-	static std::vector<std::string> mod = {"a", "b", "ab", "ba", "f", "x", "i"};
-	static std::vector<std::string> address = {"#", "$", "*", "@"};
+		if(mod < 0)
+		{
+			compilationError(ctx, "Invalid instruction modifier", lno);
 
-	bool success = true;
+			return false;
+		}
 
-	Instruction ins;
+		ins.mod = static_cast<Instruction::Modifier>(mod);
+	}
 
-	Tokenizer t(std::string(), " ", "#$@*.,", false);
+	if(!lex.isToken())
+	{
+		compilationError(ctx, "Too few instruction arguments specified", lno);
 
-	const unsigned int vsize = instructionLines_.size();
+		return false;
+	}
 
-	std::string token;
+	if(!readOperand(lex, lno, false, ins, ctx))
+		return false;
 
-	//analyze instructions
-	for(unsigned int i = 0; i < vsize; ++i)
+	if(!lex.isToken() && (ins.op == Instruction::OpCode::FRK ||
+						  ins.op == Instruction::OpCode::JMP))
 	{
-		bool defaultMod = false;
-		std::vector<std::string>::iterator it;
+		ins.bMode = Instruction::AddressMode::IMM;
+		ins.bVal = 0;
 
-		t.assign(instructionLines_[i].second);
+		ctx.result.instructions.push_back(ins);
 
-		it = std::find(op.begin(), op.end(), t.next());
+		return true;
+	}
 
-		if(it != op.end())
-			ins.op = static_cast<Instruction::OpCode>(it - op.begin());
+	if(!lex.isToken() || lex.next() != ",")
+	{
+		compilationError(ctx, "Expected \',\' before B-Value", lno);
 
-		else
-		{
-			compilationError("Invalid instruction", instructionLines_[i].first);
+		return false;
+	}
 
-			success = false;
-			continue;
-		}
+	if(!lex.isToken())
+	{
+		compilationError(ctx, "Wrong number of arguments", lno);
 
-		if(!t.isToken())
-		{
-			compilationError("No instruction arguments specified", instructionLines_[i].first);
+		return false;
+	}
 
-			success = false;
-			continue;
-		}
+	if(!readOperand(lex, lno, true, ins, ctx))
+		return false;
 
-		if( (token = t.next()) != "." )
+	if(defaultMod)
+	{
+		switch(ins.op)
 		{
-			switch(ins.op)
-			{
-			case Instruction::OpCode::KIL:
-			case Instruction::OpCode::NOP:
+		case Instruction::OpCode::MOV:
+		case Instruction::OpCode::BEQ:
+		case Instruction::OpCode::BNE:
+			if(ins.aMode == Instruction::AddressMode::IMM)
+				ins.mod = Instruction::Modifier::AB;
+			else if(ins.bMode == Instruction::AddressMode::IMM)
+				ins.mod = Instruction::Modifier::B;
+			else
+				ins.mod = Instruction::Modifier::I;
+			break;
+
+		case Instruction::OpCode::ADD:
+		case Instruction::OpCode::SUB:
+		case Instruction::OpCode::MUL:
+		case Instruction::OpCode::DIV:
+		case Instruction::OpCode::MOD:
+			if(ins.aMode == Instruction::AddressMode::IMM)
+				ins.mod = Instruction::Modifier::AB;
+			else if(ins.bMode == Instruction::AddressMode::IMM)
+				ins.mod = Instruction::Modifier::B;
+			else
 				ins.mod = Instruction::Modifier::F;
-				break;
+			break;
 
-			case Instruction::OpCode::FRK:
-			case Instruction::OpCode::JMP:
-			case Instruction::OpCode::JMZ:
-			case Instruction::OpCode::JMN:
+		case Instruction::OpCode::BLT:
+			if(ins.aMode == Instruction::AddressMode::IMM)
+				ins.mod = Instruction::Modifier::AB;
+			else
 				ins.mod = Instruction::Modifier::B;
-				break;
+			break;
 
-			default:
-				break;
-			}
-
-			defaultMod = true;
+		default:
+			break;
 		}
+	}
 
-		else
-		{
-			if(!t.isToken())
-			{
-				compilationError("Expected instruction modifier after \'.\'", instructionLines_[i].first);
-
-				success = false;
-				continue;
-			}
-
-			it = std::find(mod.begin(), mod.end(), t.next());
+	if(lex.isToken())
+	{
+		compilationError(ctx, "Too many arguments", lno);
 
-			if(it != mod.end())
-				ins.mod = static_cast<Instruction::Modifier>(it - mod.begin());
+		return false;
+	}
 
-			else
-			{
-				compilationError("Invalid instruction modifier", instructionLines_[i].first);
+	ctx.result.instructions.push_back(ins);
 
-				success = false;
-				continue;
-			}
-		}
+	return true;
+}
 
-		if(!t.isToken() && ins.op != Instruction::OpCode::JMP &&
-				ins.op != Instruction::OpCode::FRK)
-		{
-			compilationError("Too few instruction arguments specified", instructionLines_[i].first);
+//reads an optional addressing mode and a number or label; labels are
+//left for patchLabels() so they may be used before they are defined
+bool Assembler::readOperand(Lexer& lex, unsigned int lno, bool bField, Instruction& ins, Context& ctx) const
+{
+	Instruction::AddressMode& mode = bField ? ins.bMode : ins.aMode;
+	unsigned int& value = bField ? ins.bVal : ins.aVal;
 
-			success = false;
-			continue;
-		}
+	std::string_view token = lex.next();
 
-		//analyze A-field
-		if(!defaultMod)
-			token = t.next();
+	int m = addressMode(token);
 
-		it = std::find(address.begin(), address.end(), token);
+	if(m >= 0)
+	{
+		mode = static_cast<Instruction::AddressMode>(m);
 
-		if(it != address.end())
+		if(!lex.isToken())
 		{
-			ins.aMode = static_cast<Instruction::AddressMode>(it - address.begin());
-
-			if(!t.isToken())
-			{
-				compilationError("Missing A-Value", instructionLines_[i].first);
-
-				success = false;
-				continue;
-			}
-
-			token = t.next();
-
-			size_t pos = 0;
-			int val;
-			bool label = false;
-
-			try
-			{
-				val = std::stoi(token, &pos);
-			}
-			catch(std::invalid_argument& e)
-			{
-				if(labels_.count(token))
-				{
-					if(ins.aMode != Instruction::AddressMode::IMM)
-					{
-						ins.aVal = normalize(labels_[token] - i);
-						label = true;
-					}
-
-					else
-					{
-						compilationError("Label address cannot be immediate", instructionLines_[i].first);
-
-						success = false;
-						continue;
-					}
-				}
-
-				else
-				{
-					compilationError("Label \'" + token + "\' does not exist", instructionLines_[i].first);
-
-					success = false;
-					continue;
-				}
-			}
-
-			if(pos == token.size())
-				ins.aVal = normalize(val);
-
-			else if(!label)
-			{
-				compilationError("Invalid label", instructionLines_[i].first);
-
-				success = false;
-				continue;
-			}
-		}
+			compilationError(ctx, bField ? "Missing B-Value" : "Missing A-Value", lno);
 
-		else
-		{
-			ins.aMode = Instruction::AddressMode::DIR;
-
-			size_t pos = 0;
-			int val;
-			bool label = false;
-
-			try
-			{
-				val = std::stoi(token, &pos);
-			}
-			catch(std::invalid_argument& e)
-			{
-				if(labels_.count(token))
-				{
-					ins.aVal = normalize(labels_[token] - i);
-					label = true;
-				}
-
-				else
-				{
-					compilationError("Label \'" + token + "\' does not exist", instructionLines_[i].first);
-
-					success = false;
-					continue;
-				}
-			}
-
-			if(pos == token.size())
-				ins.aVal = normalize(val);
-
-			else if(!label)
-			{
-				compilationError("Invalid label", instructionLines_[i].first);
-
-				success = false;
-				continue;
-			}
+			return false;
 		}
 
-		if(!t.isToken())
-		{
-			if(ins.op == Instruction::OpCode::FRK ||
-					ins.op == Instruction::OpCode::JMP)
-			{
-				ins.bMode = Instruction::AddressMode::IMM;
-				ins.bVal = 0;
+		token = lex.next();
+	}
 
-				assembledInstructions_.push_back(ins);
+	else
+		mode = Instruction::AddressMode::DIR;
 
-				continue;
-			}
-		}
+	int n;
 
-		//look for a comma
-		token = t.next();
+	switch(parseNumber(token, n))
+	{
+	case NUMBER:
+		value = normalize(n);
+		return true;
 
-		if(token != ",")
-		{
-			compilationError("Expected \',\' before B-Value", instructionLines_[i].first);
+	case PARTIAL_NUMBER:
+		compilationError(ctx, "Invalid label", lno);
+		return false;
 
-			success = false;
-			continue;
-		}
+	case OUT_OF_RANGE:
+		compilationError(ctx, "Value out of range", lno);
+		return false;
 
-		if(!t.isToken())
-		{
-			compilationError("Wrong number of arguments", instructionLines_[i].first);
+	case NOT_A_NUMBER:
+		break;
+	}
 
-			success = false;
-			continue;
-		}
+	value = 0;
+
+	ctx.fixups.push_back(Fixup{ctx.index, lno, ctx.labels.intern(token), token, bField,
+							   mode == Instruction::AddressMode::IMM});
 
-		//analyze B-field
-		token = t.next();
+	return true;
+}
 
-		it = std::find(address.begin(), address.end(), token);
+//resolves the label operands, patching them in only if every
+//instruction has been assembled
+bool Assembler::patchLabels(Context& ctx) const
+{
+	bool success = true;
+	bool complete = ctx.result.instructions.size() == ctx.index;
 
-		if(it != address.end())
-		{
-			ins.bMode = static_cast<Instruction::AddressMode>(it - address.begin());
-
-			if(!t.isToken())
-			{
-				compilationError("Missing B-Value", instructionLines_[i].first);
-
-				success = false;
-				continue;
-			}
-
-			token = t.next();
-
-			size_t pos = 0;
-			int val;
-			bool label = false;
-
-			try
-			{
-				val = std::stoi(token, &pos);
-			}
-			catch(std::invalid_argument& e)
-			{
-				if(labels_.count(token))
-				{
-					if(ins.bMode != Instruction::AddressMode::IMM)
-					{
-						ins.bVal = normalize(labels_[token] - i);
-						label = true;
-					}
-
-					else
-					{
-						compilationError("Label address cannot be immediate", instructionLines_[i].first);
-
-						success = false;
-						continue;
-					}
-				}
-
-				else
-				{
-					compilationError("Label \'" + token + "\' does not exist", instructionLines_[i].first);
-
-					success = false;
-					continue;
-				}
-			}
-
-			if(pos == token.size())
-			{
-				ins.bVal = normalize(val);
-			}
-
-			else if(!label)
-			{
-				compilationError("Invalid label", instructionLines_[i].first);
-
-				success = false;
-				continue;
-			}
-		}
+	for(const auto& f : ctx.fixups)
+	{
+		int target = ctx.labels.value(f.symbol);
 
-		else
+		if(target == SymbolTable::Undefined)
 		{
-			ins.bMode = Instruction::AddressMode::DIR;
-
-			size_t pos = 0;
-			int val;
-			bool label = false;
-
-			try
-			{
-				val = std::stoi(token, &pos);
-			}
-			catch(std::invalid_argument& e)
-			{
-				if(labels_.count(token))
-				{
-					ins.bVal = normalize(labels_[token] - i);
-					label = true;
-				}
-
-				else
-				{
-					compilationError("Label \'" + token + "\' does not exist", instructionLines_[i].first);
-
-					success = false;
-					continue;
-				}
-			}
-
-			if(pos == token.size())
-				ins.bVal = normalize(val);
-
-			else if(!label)
-			{
-				compilationError("Invalid label", instructionLines_[i].first);
-
-				success = false;
-				continue;
-			}
-		}
+			compilationError(ctx, "Label \'" + std::string(f.label) + "\' does not exist", f.line);
 
-		if(defaultMod)
-		{
-			switch(ins.op)
-			{
-			case Instruction::OpCode::MOV:
-			case Instruction::OpCode::BEQ:
-			case Instruction::OpCode::BNE:
-				if(ins.aMode == Instruction::AddressMode::IMM)
-					ins.mod = Instruction::Modifier::AB;
-				else if(ins.bMode == Instruction::AddressMode::IMM)
-					ins.mod = Instruction::Modifier::B;
-				else
-					ins.mod = Instruction::Modifier::I;
-				break;
-
-			case Instruction::OpCode::ADD:
-			case Instruction::OpCode::SUB:
-			case Instruction::OpCode::MUL:
-			case Instruction::OpCode::DIV:
-			case Instruction::OpCode::MOD:
-				if(ins.aMode == Instruction::AddressMode::IMM)
-					ins.mod = Instruction::Modifier::AB;
-				else if(ins.bMode == Instruction::AddressMode::IMM)
-					ins.mod = Instruction::Modifier::B;
-				else
-					ins.mod = Instruction::Modifier::F;
-				break;
-
-			case Instruction::OpCode::BLT:
-				if(ins.aMode == Instruction::AddressMode::IMM)
-					ins.mod = Instruction::Modifier::AB;
-				else
-					ins.mod = Instruction::Modifier::B;
-				break;
-
-			default:
-				break;
-			}
+			success = false;
 		}
 
-		if(t.isToken())
+		else if(f.immediate)
 		{
-			compilationError("Too many arguments", instructionLines_[i].first);
+			compilationError(ctx, "Label address cannot be immediate", f.line);
 
 			success = false;
-			continue;
 		}
 
-		if(success)
-			assembledInstructions_.push_back(ins);
-	}//for
+		else if(complete)
+		{
+			Instruction& ins = ctx.result.instructions[f.index];
 
-	if(!success)
-		assembledInstructions_.clear();
+			(f.bField ? ins.bVal : ins.aVal) = normalize(target - static_cast<int>(f.index));
+		}
+	}
 
 	return success;
 }
 
-void Assembler::compilationError(const std::string & err, unsigned int lnumber)
+void Assembler::compilationError(Context& ctx, const std::string& err, unsigned int lnumber) const
 {
-	std::cerr << fname_ << ':' << lnumber << ": " << err << std::endl;
+	ctx.result.diagnostics.push_back(Diagnostic{lnumber, err});
 }
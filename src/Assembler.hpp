@@ -2,22 +2,68 @@
 #define ASSEMBLER_HPP
 
 #include "VirtualMachine.hpp"
+#include "Lexer.hpp"
+#include "SymbolTable.hpp"
 
-#include <unordered_map>
 #include <utility>
-
-#include <fstream>
-
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/*!
+ * \brief Redcode assembler
+ *
+ * assemble() keeps no state between calls and returns the instructions
+ * and diagnostics by value, so any number of threads may assemble
+ * through one instance. openFile()/assembly() are the older stateful
+ * interface, kept for callers using getInstance(); they print the
+ * diagnostics to std::cerr.
+ */
 class Assembler
 {
-	using uint = unsigned int;
-
-	using dictionary = std::unordered_map<std::string, int>;
+	using Instruction = VirtualMachine::Core::Instruction;
 
 public:
 
+	struct Diagnostic
+	{
+		unsigned int line;
+
+		std::string message;
+	};
+
+	/*!
+	 * \brief Outcome of one assembly, instructions are empty unless it succeeded
+	 */
+	struct Result
+	{
+		bool success = false;
+
+		std::vector<Instruction> instructions;
+
+		std::vector<Diagnostic> diagnostics;
+	};
+
+	/*!
+	 * \brief Bumped whenever the same source may assemble differently, invalidates AssemblyCache entries
+	 */
+	static constexpr unsigned int Version = 1;
+
+	/*!
+	 * \brief Assembler normalizing field values modulo the given core size
+	 */
+	explicit Assembler(unsigned int = 8000);
+
 	static Assembler& getInstance();
 
+	Result assemble(const char*, std::size_t) const;
+
+	Result assemble(const std::string&) const;
+
+	Result assembleFile(const char*) const;
+
+	unsigned int getCoreSize() const;
+
 	void openFile(const char*);
 
 	bool assembly();
@@ -30,31 +76,54 @@ public:
 
 private:
 
-	using Instruction = VirtualMachine::Core::Instruction;
+	//label operand resolved once the whole source has been read
+	struct Fixup
+	{
+		unsigned int index;
+		unsigned int line;
+
+		unsigned int symbol;
+
+		std::string_view label;
+
+		bool bField;
+		bool immediate;
+	};
+
+	//state of a single assemble() call
+	struct Context
+	{
+		SymbolTable labels;
+
+		std::vector<Fixup> fixups;
+
+		unsigned int index = 0;
 
-	Assembler();
+		Result result;
+	};
 
 	Assembler(const Assembler&) = delete;
 	Assembler& operator=(const Assembler&) = delete;
 
-	bool readLabels();
+	bool readLine(Lexer&, unsigned int, Context&) const;
 
-	bool readInstructions();
+	bool readInstruction(std::string_view, Lexer&, unsigned int, Context&) const;
 
-	std::vector<std::pair<uint, std::string>> instructionLines_;
-	std::vector<Instruction> assembledInstructions_;
+	bool readOperand(Lexer&, unsigned int, bool, Instruction&, Context&) const;
 
-	void compilationError(const std::string&, unsigned int);
+	bool patchLabels(Context&) const;
 
-	unsigned int normalize(int, unsigned int = 8000);
+	void compilationError(Context&, const std::string&, unsigned int) const;
 
-	bool assembled_;
+	unsigned int normalize(int) const;
 
-	std::ifstream fin_;
+	unsigned int coreSize_;
 
-	std::string fname_;
+	std::vector<Instruction> assembledInstructions_;
 
-	dictionary labels_;
+	bool assembled_;
+
+	std::string fname_;
 };
 
 #endif // ASSEMBLER_HPP
@@ -0,0 +1,150 @@
+#include "AssemblyCache.hpp"
+#include "ObjectFile.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+AssemblyCache::AssemblyCache(const std::string& directory, unsigned int coreSize)
+	: directory_(directory),
+	  assembler_(coreSize),
+	  hits_(0),
+	  misses_(0)
+{}
+
+auto AssemblyCache::assemble(const char* data, std::size_t size) const -> Result
+{
+	std::uint64_t k = key(data, size, assembler_.getCoreSize());
+
+	try
+	{
+		ObjectFile obj(getEntryPath(k).c_str());
+
+		if(obj.getCoreSize() == assembler_.getCoreSize())
+		{
+			++hits_;
+
+			Result res;
+
+			res.success = true;
+			res.instructions = obj.getInstructions();
+
+			return res;
+		}
+	}
+
+	catch(const std::runtime_error&)
+	{
+		//missing or corrupt entry, assembled and stored again below
+	}
+
+	++misses_;
+
+	Result res = assembler_.assemble(data, size);
+
+	if(res.success)
+		store(k, res);
+
+	return res;
+}
+
+auto AssemblyCache::assemble(const std::string& source) const -> Result
+{
+	return assemble(source.data(), source.size());
+}
+
+auto AssemblyCache::assembleFile(const char* fname) const -> Result
+{
+	std::unique_ptr<MappedFile> file;
+
+	try
+	{
+		file.reset(new MappedFile(fname));
+	}
+
+	catch(const std::runtime_error&)
+	{
+		//reported by the assembler
+		return assembler_.assembleFile(fname);
+	}
+
+	return assemble(file->data(), file->size());
+}
+
+std::uint64_t AssemblyCache::key(const char* data, std::size_t size, unsigned int coreSize)
+{
+	//FNV-1a over the assembler version, the core size and the source
+	std::uint64_t h = 14695981039346656037ull;
+
+	auto mix = [&h](unsigned char c)
+	{
+		h = (h ^ c) * 1099511628211ull;
+	};
+
+	for(unsigned int n : {Assembler::Version, coreSize})
+		for(int i = 0; i < 4; ++i)
+			mix(static_cast<unsigned char>(n >> 8 * i));
+
+	for(std::size_t i = 0; i < size; ++i)
+		mix(static_cast<unsigned char>(data[i]));
+
+	return h;
+}
+
+const std::string& AssemblyCache::getDirectory() const
+{
+	return directory_;
+}
+
+unsigned int AssemblyCache::getHits() const
+{
+	return hits_;
+}
+
+unsigned int AssemblyCache::getMisses() const
+{
+	return misses_;
+}
+
+std::string AssemblyCache::getEntryPath(std::uint64_t k) const
+{
+	char name[17];
+
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(k));
+
+	return directory_ + '/' + name + ".cwo";
+}
+
+void AssemblyCache::store(std::uint64_t k, const Result& res) const
+{
+	std::string image;
+
+	try
+	{
+		image = ObjectFile::encode(res.instructions, assembler_.getCoreSize());
+	}
+
+	catch(const std::invalid_argument&)
+	{
+		//core too large for the object format
+		return;
+	}
+
+	std::string target = getEntryPath(k);
+
+	//unique per writer, so concurrent stores of one key never share a file
+	std::string tmp = target + '.' + std::to_string(std::random_device()()) + ".tmp";
+
+	std::ofstream fout(tmp, std::ofstream::out |
+					   std::ofstream::binary |
+					   std::ofstream::trunc);
+
+	fout.write(image.data(), image.size());
+	fout.close();
+
+	if(!fout || std::rename(tmp.c_str(), target.c_str()))
+		std::remove(tmp.c_str());
+}
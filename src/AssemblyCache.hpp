@@ -0,0 +1,70 @@
+#ifndef ASSEMBLYCACHE_HPP
+#define ASSEMBLYCACHE_HPP
+
+#include "Assembler.hpp"
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/*!
+ * \brief On-disk cache of assembled warriors, keyed by their source
+ *
+ * The key is a 64 bit FNV-1a hash of the source text, the core size and
+ * Assembler::Version. Every successful assembly is stored as an
+ * ObjectFile named after its key in the cache directory; a hit maps it
+ * back instead of running the assembler. Failed assemblies are not
+ * stored, so their diagnostics are always fresh.
+ *
+ * Entries are written to a temporary file and renamed into place, so
+ * threads and processes may share a directory. An unreadable or corrupt
+ * entry counts as a miss and is replaced; a directory that cannot be
+ * written to only costs the caching.
+ */
+class AssemblyCache
+{
+public:
+
+	using Result = Assembler::Result;
+
+	explicit AssemblyCache(const std::string&, unsigned int = 8000);
+
+	Result assemble(const char*, std::size_t) const;
+
+	Result assemble(const std::string&) const;
+
+	Result assembleFile(const char*) const;
+
+	/*!
+	 * \brief Key of the given source for the given core size
+	 */
+	static std::uint64_t key(const char*, std::size_t, unsigned int);
+
+	const std::string& getDirectory() const;
+
+	/*!
+	 * \brief File holding the entry with the given key
+	 */
+	std::string getEntryPath(std::uint64_t) const;
+
+	unsigned int getHits() const;
+
+	unsigned int getMisses() const;
+
+private:
+
+	AssemblyCache(const AssemblyCache&) = delete;
+	AssemblyCache& operator=(const AssemblyCache&) = delete;
+
+	void store(std::uint64_t, const Result&) const;
+
+	std::string directory_;
+
+	Assembler assembler_;
+
+	mutable std::atomic<unsigned int> hits_;
+	mutable std::atomic<unsigned int> misses_;
+};
+
+#endif //ASSEMBLYCACHE_HPP
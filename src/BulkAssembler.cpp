@@ -0,0 +1,68 @@
+#include "BulkAssembler.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+BulkAssembler::BulkAssembler(unsigned int coreSize, unsigned int threads)
+	: assembler_(coreSize),
+	  pool_(threads)
+{}
+
+void BulkAssembler::setCache(const std::string& directory)
+{
+	if(directory.empty())
+		cache_.reset();
+	else
+		cache_.reset(new AssemblyCache(directory, assembler_.getCoreSize()));
+}
+
+auto BulkAssembler::assemble(const std::vector<std::string>& files) -> std::vector<Unit>
+{
+	std::vector<Unit> units(files.size());
+
+	for(std::size_t i = 0; i < files.size(); ++i)
+	{
+		Unit& unit = units[i];
+
+		unit.fname = files[i];
+
+		pool_.submit([this, &unit](unsigned int)
+		{
+			if(cache_)
+				unit.result = cache_->assembleFile(unit.fname.c_str());
+			else
+				unit.result = assembler_.assembleFile(unit.fname.c_str());
+		});
+	}
+
+	pool_.wait();
+
+	return units;
+}
+
+std::vector<std::string> BulkAssembler::listSources(const std::string& directory, const std::string& extension)
+{
+	namespace fs = std::filesystem;
+
+	std::vector<std::string> files;
+
+	std::error_code ec;
+
+	for(fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec))
+	{
+		//broken links and the like are skipped, not reported
+		std::error_code entry;
+
+		if(it->path().extension() == extension && it->is_regular_file(entry))
+			files.push_back(it->path().string());
+	}
+
+	if(ec)
+		throw std::runtime_error("Cannot read directory " + directory + ": " + ec.message());
+
+	std::sort(files.begin(), files.end());
+
+	return files;
+}
@@ -0,0 +1,61 @@
+#ifndef BULKASSEMBLER_HPP
+#define BULKASSEMBLER_HPP
+
+#include "Assembler.hpp"
+#include "AssemblyCache.hpp"
+#include "ThreadPool.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+
+/*!
+ * \brief Assembles many source files at once on a ThreadPool
+ *
+ * Every file is a separate task writing only its own Unit, and nothing
+ * is printed, so the diagnostics of one file stay together and come
+ * back in the order the files were given. With a cache directory the
+ * files go through an AssemblyCache and unchanged sources are not
+ * assembled again.
+ */
+class BulkAssembler
+{
+public:
+
+	struct Unit
+	{
+		std::string fname;
+
+		Assembler::Result result;
+	};
+
+	BulkAssembler(unsigned int = 8000,
+				  unsigned int = std::thread::hardware_concurrency());
+
+	/*!
+	 * \brief Caches assembled sources in the given existing directory, none if empty
+	 */
+	void setCache(const std::string&);
+
+	std::vector<Unit> assemble(const std::vector<std::string>&);
+
+	/*!
+	 * \brief Sorted paths of the files with the given extension directly in the directory,
+	 * throws std::runtime_error if it cannot be read
+	 */
+	static std::vector<std::string> listSources(const std::string&, const std::string& = ".red");
+
+private:
+
+	BulkAssembler(const BulkAssembler&) = delete;
+	BulkAssembler& operator=(const BulkAssembler&) = delete;
+
+	Assembler assembler_;
+
+	std::unique_ptr<AssemblyCache> cache_;
+
+	ThreadPool pool_;
+};
+
+#endif //BULKASSEMBLER_HPP
@@ -0,0 +1,127 @@
+#include "Heatmap.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+Heatmap::Heatmap(unsigned int size)
+{
+	resize(size);
+}
+
+void Heatmap::assign(const Heatmap& other)
+{
+	if(&other == this)
+		return;
+
+	size_ = other.size_;
+
+	pages_.resize(other.pages_.size());
+
+	for(std::size_t n = 0; n < pages_.size(); ++n)
+	{
+		if(pages_[n].use_count() == 1)
+			*pages_[n] = *other.pages_[n];
+
+		else
+			pages_[n] = std::make_shared<Page>(*other.pages_[n]);
+	}
+}
+
+void Heatmap::detach(unsigned int n)
+{
+	pages_[n] = std::make_shared<Page>(*pages_[n]);
+}
+
+void Heatmap::resize(unsigned int size)
+{
+	size_ = size;
+
+	pages_.resize((Accesses * size_ + PageCounters - 1) / PageCounters);
+
+	reset();
+}
+
+void Heatmap::reset()
+{
+	for(auto& page : pages_)
+	{
+		if(page.use_count() == 1)
+			page->fill(0);
+
+		else
+			page = std::make_shared<Page>();
+	}
+}
+
+Heatmap& Heatmap::operator+=(const Heatmap& other)
+{
+	if(other.size_ != size_)
+		throw std::invalid_argument("Heatmap sizes do not match");
+
+	for(unsigned int a = 0; a < Accesses; ++a)
+		for(unsigned int adr = 0; adr < size_; ++adr)
+		{
+			unsigned int n = other.get(static_cast<Access>(a), adr);
+
+			if(!n)
+				continue;
+
+			unsigned int i = a * size_ + adr;
+
+			if(pages_[i / PageCounters].use_count() != 1)
+				detach(i / PageCounters);
+
+			(*pages_[i / PageCounters])[i % PageCounters] += n;
+		}
+
+	return *this;
+}
+
+unsigned int Heatmap::getSize() const
+{
+	return size_;
+}
+
+unsigned int Heatmap::getMax(Access a) const
+{
+	unsigned int max = 0;
+
+	for(unsigned int adr = 0; adr < size_; ++adr)
+		max = std::max(max, get(a, adr));
+
+	return max;
+}
+
+std::string Heatmap::toCsv(const Heatmap& p1, const Heatmap& p2)
+{
+	if(p1.size_ != p2.size_)
+		throw std::invalid_argument("Heatmap sizes do not match");
+
+	std::string out = "adr,p1_exec,p1_read,p1_write,p2_exec,p2_read,p2_write\n";
+
+	for(unsigned int adr = 0; adr < p1.size_; ++adr)
+	{
+		out += std::to_string(adr);
+
+		for(const Heatmap* h : {&p1, &p2})
+			for(unsigned int a = 0; a < Accesses; ++a)
+				out += ',' + std::to_string(h->get(static_cast<Access>(a), adr));
+
+		out += '\n';
+	}
+
+	return out;
+}
+
+void Heatmap::writeCsv(const char* fname, const Heatmap& p1, const Heatmap& p2)
+{
+	std::string csv = toCsv(p1, p2);
+
+	std::ofstream fout(fname, std::ofstream::out | std::ofstream::trunc);
+
+	fout.write(csv.data(), csv.size());
+
+	if(!fout)
+		throw std::runtime_error(std::string("Cannot write ") + fname);
+}
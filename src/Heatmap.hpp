@@ -0,0 +1,102 @@
+#ifndef HEATMAP_HPP
+#define HEATMAP_HPP
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <string>
+
+/*!
+ * \brief Per-cell access counts of one player
+ *
+ * Executions, reads and writes are counted in one flat array, a row of
+ * getSize() counters per Access, held in pages of PageCounters. Copies
+ * share the pages, read-only, until one side adds to them: that side
+ * then copies only the page it writes to, so copying a Heatmap, as a
+ * VM snapshot does, costs one pointer per page instead of the counters.
+ * Copying never writes to the source.
+ *
+ * Recording an access is a single increment once no copy shares the
+ * page. add() does not check the address; it has to be below the size
+ * the Heatmap was created or resized with.
+ */
+class Heatmap
+{
+public:
+
+	enum Access {EXEC, READ, WRITE};
+
+	explicit Heatmap(unsigned int = 0);
+
+	void add(Access a, unsigned int adr)
+	{
+		unsigned int i = a * size_ + adr;
+
+		std::shared_ptr<Page>& page = pages_[i / PageCounters];
+
+		if(page.use_count() != 1)
+			detach(i / PageCounters);
+
+		++(*page)[i % PageCounters];
+	}
+
+	/*!
+	 * \brief Copies the counts into pages of its own
+	 *
+	 * Unlike a copy, shares nothing with the source, which then keeps
+	 * counting without copying pages. For copies taken over and over
+	 * from a running match.
+	 */
+	void assign(const Heatmap&);
+
+	/*!
+	 * \brief Sets the number of cells, every count starts at zero
+	 */
+	void resize(unsigned int);
+
+	void reset();
+
+	/*!
+	 * \brief Sums the counts, throws std::invalid_argument if the sizes differ
+	 */
+	Heatmap& operator+=(const Heatmap&);
+
+	unsigned int getSize() const;
+
+	unsigned int get(Access a, unsigned int adr) const
+	{
+		unsigned int i = a * size_ + adr;
+
+		return (*pages_[i / PageCounters])[i % PageCounters];
+	}
+
+	unsigned int getMax(Access) const;
+
+	/*!
+	 * \brief One line per cell, with the counts of both players
+	 *
+	 * Starts with the header line
+	 * "adr,p1_exec,p1_read,p1_write,p2_exec,p2_read,p2_write".
+	 * Throws std::invalid_argument if the sizes differ.
+	 */
+	static std::string toCsv(const Heatmap&, const Heatmap&);
+
+	static void writeCsv(const char*, const Heatmap&, const Heatmap&);
+
+private:
+
+	static constexpr unsigned int Accesses = WRITE + 1;
+
+	static constexpr unsigned int PageCounters = 256;
+
+	using Page = std::array<unsigned int, PageCounters>;
+
+	//replaces a shared page by a private copy
+	void detach(unsigned int);
+
+	std::vector<std::shared_ptr<Page>> pages_;
+
+	unsigned int size_;
+};
+
+#endif //HEATMAP_HPP
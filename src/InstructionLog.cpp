@@ -0,0 +1,83 @@
+#include "InstructionLog.hpp"
+
+#include <stdexcept>
+
+InstructionLog::InstructionLog(std::size_t capacity)
+	: capacity_(capacity),
+	  head_(0),
+	  total_(0)
+{
+	if(!capacity_)
+		throw std::invalid_argument("Log capacity cannot be zero");
+}
+
+void InstructionLog::push(unsigned int cycle, unsigned int adr, const Instruction& ins)
+{
+	++total_;
+
+	if(entries_.size() < capacity_)
+	{
+		entries_.push_back(Entry{cycle, adr, ins});
+
+		return;
+	}
+
+	entries_[head_] = Entry{cycle, adr, ins};
+
+	if(++head_ == capacity_)
+		head_ = 0;
+}
+
+void InstructionLog::append(const InstructionLog& other)
+{
+	//only the newest capacity_ entries can survive
+	std::size_t skip = other.size() > capacity_ ? other.size() - capacity_ : 0;
+
+	for(std::size_t i = skip; i < other.size(); ++i)
+	{
+		const Entry& e = other[i];
+
+		push(e.cycle, e.adr, e.ins);
+	}
+
+	//entries the other log had already dropped still count
+	total_ += other.total_ - (other.size() - skip);
+}
+
+void InstructionLog::clear()
+{
+	entries_.clear();
+
+	head_ = 0;
+	total_ = 0;
+}
+
+std::size_t InstructionLog::size() const
+{
+	return entries_.size();
+}
+
+std::size_t InstructionLog::capacity() const
+{
+	return capacity_;
+}
+
+unsigned long long InstructionLog::getTotal() const
+{
+	return total_;
+}
+
+auto InstructionLog::operator[](std::size_t i) const -> const Entry&
+{
+	i += head_;
+
+	if(i >= entries_.size())
+		i -= entries_.size();
+
+	return entries_[i];
+}
+
+std::string InstructionLog::format(const Entry& e)
+{
+	return VirtualMachine::StatReport::toString(e.ins);
+}
@@ -0,0 +1,75 @@
+#ifndef INSTRUCTIONLOG_HPP
+#define INSTRUCTIONLOG_HPP
+
+#include "VirtualMachine.hpp"
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+/*!
+ * \brief Fixed-capacity ring of executed instructions
+ *
+ * Entries are kept in binary form and formatted only when asked for, so
+ * logging costs a copy of a few words per instruction. Once full, every
+ * new entry replaces the oldest one; storage grows with the entries up
+ * to the capacity and never beyond it.
+ */
+class InstructionLog
+{
+public:
+
+	using Instruction = VirtualMachine::Core::Instruction;
+
+	struct Entry
+	{
+		unsigned int cycle;
+
+		unsigned int adr;
+
+		Instruction ins;
+	};
+
+	explicit InstructionLog(std::size_t = 4096);
+
+	void push(unsigned int, unsigned int, const Instruction&);
+
+	/*!
+	 * \brief Appends the entries of another log, oldest first
+	 */
+	void append(const InstructionLog&);
+
+	void clear();
+
+	std::size_t size() const;
+
+	std::size_t capacity() const;
+
+	/*!
+	 * \brief Entries pushed since the last clear(), including the ones dropped
+	 */
+	unsigned long long getTotal() const;
+
+	/*!
+	 * \brief Entry by age, 0 is the oldest one kept
+	 */
+	const Entry& operator[](std::size_t) const;
+
+	/*!
+	 * \brief Same text as StatReport::toString()
+	 */
+	static std::string format(const Entry&);
+
+private:
+
+	std::vector<Entry> entries_;
+
+	std::size_t capacity_;
+
+	//slot of the oldest entry once the ring is full
+	std::size_t head_;
+
+	unsigned long long total_;
+};
+
+#endif //INSTRUCTIONLOG_HPP
@@ -0,0 +1,43 @@
+#include "Lexer.hpp"
+
+#include <stdexcept>
+
+Lexer::Lexer(const char* dropped, const char* kept)
+	: Lexer(std::string_view(), dropped, kept)
+{}
+
+Lexer::Lexer(std::string_view text, const char* dropped, const char* kept)
+{
+	classes_.fill(TOKEN);
+
+	for(; *dropped; ++dropped)
+		classes_[static_cast<unsigned char>(*dropped)] = DROPPED;
+
+	for(; *kept; ++kept)
+		classes_[static_cast<unsigned char>(*kept)] = KEPT;
+
+	assign(text);
+}
+
+void Lexer::assign(std::string_view text)
+{
+	pos_ = text.data();
+	end_ = text.data() + text.size();
+}
+
+void Lexer::noToken()
+{
+	throw std::out_of_range("No token left");
+}
+
+bool Lexer::equals(std::string_view token, std::string_view keyword)
+{
+	if(token.size() != keyword.size())
+		return false;
+
+	for(std::size_t i = 0; i < token.size(); ++i)
+		if(lower(token[i]) != keyword[i])
+			return false;
+
+	return true;
+}
@@ -0,0 +1,100 @@
+#ifndef LEXER_HPP
+#define LEXER_HPP
+
+#include <array>
+#include <string_view>
+
+/*!
+ * \brief Splits a buffer into tokens without copying it
+ *
+ * Every byte is classified through a 256-entry table: dropped
+ * separators end a token and are skipped, kept separators end a token
+ * and are returned as one-character tokens of their own. Tokens are
+ * views into the assigned buffer, which has to outlive them.
+ */
+class Lexer
+{
+public:
+
+	Lexer(const char*, const char* = "");
+
+	Lexer(std::string_view, const char*, const char* = "");
+
+	void assign(std::string_view);
+
+	/*!
+	 * \brief Next token, throws std::out_of_range when there is none
+	 */
+	std::string_view next();
+
+	bool isToken();
+
+	/*!
+	 * \brief Compares a token with a lowercase keyword, ignoring the case of the token
+	 */
+	static bool equals(std::string_view, std::string_view);
+
+	/*!
+	 * \brief ASCII lowercase, as the Redcode vocabulary is ASCII only
+	 */
+	static char lower(char c)
+	{
+		return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+	}
+
+	/*!
+	 * \brief Next token without consuming it, throws std::out_of_range when there is none
+	 */
+	std::string_view peek();
+
+private:
+
+	enum CharClass : unsigned char {TOKEN, DROPPED, KEPT};
+
+	CharClass classOf(char c) const
+	{
+		return classes_[static_cast<unsigned char>(c)];
+	}
+
+	[[noreturn]] static void noToken();
+
+	std::array<CharClass, 256> classes_;
+
+	const char* pos_;
+	const char* end_;
+};
+
+inline bool Lexer::isToken()
+{
+	while(pos_ != end_ && classOf(*pos_) == DROPPED)
+		++pos_;
+
+	return pos_ != end_;
+}
+
+inline std::string_view Lexer::next()
+{
+	if(!isToken())
+		noToken();
+
+	const char* begin = pos_++;
+
+	if(classOf(*begin) != KEPT)
+		while(pos_ != end_ && classOf(*pos_) == TOKEN)
+			++pos_;
+
+	return std::string_view(begin, pos_ - begin);
+}
+
+inline std::string_view Lexer::peek()
+{
+	const char* pos = pos_;
+
+	std::string_view tok = next();
+
+	pos_ = pos;
+
+	return tok;
+}
+
+#endif //LEXER_HPP
@@ -0,0 +1,122 @@
+#include "MappedFile.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define COREWAR_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const char* fname)
+	: data_(nullptr),
+	  size_(0),
+	  mapped_(false)
+{
+#ifdef COREWAR_MMAP
+	int fd = open(fname, O_RDONLY);
+
+	if(fd < 0)
+		throw std::runtime_error(std::string("Cannot open ") + fname);
+
+	struct stat st;
+
+	if(fstat(fd, &st) < 0)
+	{
+		close(fd);
+
+		throw std::runtime_error(std::string("Cannot read ") + fname);
+	}
+
+	size_ = st.st_size;
+
+	//an empty file cannot be mapped, it is left as an empty buffer
+	if(size_)
+	{
+		void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if(p == MAP_FAILED)
+		{
+			close(fd);
+
+			throw std::runtime_error(std::string("Cannot map ") + fname);
+		}
+
+		data_ = static_cast<const char*>(p);
+		mapped_ = true;
+	}
+
+	close(fd);
+#else
+	std::ifstream fin(fname, std::ifstream::in | std::ifstream::binary);
+
+	if(!fin)
+		throw std::runtime_error(std::string("Cannot open ") + fname);
+
+	buffer_.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+
+	data_ = buffer_.data();
+	size_ = buffer_.size();
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: data_(other.data_),
+	  size_(other.size_),
+	  mapped_(other.mapped_),
+	  buffer_(std::move(other.buffer_))
+{
+	other.data_ = nullptr;
+	other.size_ = 0;
+	other.mapped_ = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if(this != &other)
+	{
+		unmap();
+
+		data_ = other.data_;
+		size_ = other.size_;
+		mapped_ = other.mapped_;
+		buffer_ = std::move(other.buffer_);
+
+		other.data_ = nullptr;
+		other.size_ = 0;
+		other.mapped_ = false;
+	}
+
+	return *this;
+}
+
+const char* MappedFile::data() const
+{
+	return data_;
+}
+
+std::size_t MappedFile::size() const
+{
+	return size_;
+}
+
+void MappedFile::unmap()
+{
+#ifdef COREWAR_MMAP
+	if(mapped_)
+		munmap(const_cast<char*>(data_), size_);
+#endif
+
+	mapped_ = false;
+}
@@ -0,0 +1,45 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <vector>
+#include <cstddef>
+
+/*!
+ * \brief Read-only view of a whole file
+ *
+ * The file is memory-mapped where the platform supports it and read
+ * into a buffer otherwise. Throws std::runtime_error when the file
+ * cannot be opened.
+ */
+class MappedFile
+{
+public:
+
+	explicit MappedFile(const char*);
+
+	~MappedFile();
+
+	MappedFile(MappedFile&&) noexcept;
+	MappedFile& operator=(MappedFile&&) noexcept;
+
+	const char* data() const;
+
+	std::size_t size() const;
+
+private:
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	void unmap();
+
+	const char* data_;
+
+	std::size_t size_;
+
+	bool mapped_;
+
+	std::vector<char> buffer_;
+};
+
+#endif //MAPPEDFILE_HPP
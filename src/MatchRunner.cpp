@@ -0,0 +1,280 @@
+#include "MatchRunner.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+
+//cycles run flat out between two looks at the requests
+const unsigned int BatchCycles = 1000;
+
+}
+
+MatchRunner::MatchRunner()
+	: vm_(new StandardVirtualMachine),
+	  owner_(vm_->getCoreSize(), 0),
+	  interval_(0),
+	  steps_(0),
+	  running_(false),
+	  busy_(false),
+	  quit_(false)
+{
+	frame_.result = vm_->getResult();
+	frame_.running = false;
+
+	worker_ = std::thread(&MatchRunner::run, this);
+}
+
+MatchRunner::~MatchRunner()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		quit_ = true;
+	}
+
+	wake_.notify_all();
+
+	worker_.join();
+}
+
+void MatchRunner::load(const std::vector<Instruction>& v, unsigned int offset, bool isP1)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	halt(lock);
+
+	vm_->loadProgram(v, offset, isP1);
+
+	frame_.result = vm_->getResult();
+}
+
+void MatchRunner::reset()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	halt(lock);
+
+	vm_->reset();
+	vm_->getP1Report().reset();
+	vm_->getP2Report().reset();
+
+	for(auto adr : dirty_)
+		owner_[adr] = 0;
+
+	dirty_.clear();
+
+	frame_.p1Log.clear();
+	frame_.p2Log.clear();
+	frame_.result = vm_->getResult();
+}
+
+void MatchRunner::start()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		running_ = frame_.result.state == VirtualMachine::ONGOING;
+	}
+
+	wake_.notify_all();
+}
+
+void MatchRunner::stop()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	running_ = false;
+}
+
+void MatchRunner::step()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		++steps_;
+	}
+
+	wake_.notify_all();
+}
+
+void MatchRunner::setInterval(std::chrono::nanoseconds interval)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		interval_ = interval;
+	}
+
+	wake_.notify_all();
+}
+
+auto MatchRunner::takeFrame() -> Frame
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Frame out;
+
+	for(auto adr : dirty_)
+	{
+		(owner_[adr] == 1 ? out.p1Writes : out.p2Writes).push_back(adr);
+
+		owner_[adr] = 0;
+	}
+
+	dirty_.clear();
+
+	std::swap(out.p1Log, frame_.p1Log);
+	std::swap(out.p2Log, frame_.p2Log);
+
+	out.result = frame_.result;
+	out.running = running_ || steps_ || busy_;
+
+	return out;
+}
+
+void MatchRunner::copyHeatmaps(Heatmap& p1, Heatmap& p2)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	//the worker cannot start another batch while the mutex is held
+	idle_.wait(lock, [this]() { return !busy_; });
+
+	//copied rather than shared, or every page the match counts into
+	//next would have to be copied again
+	p1.assign(vm_->getP1Report().getHeatmap());
+	p2.assign(vm_->getP2Report().getHeatmap());
+}
+
+unsigned int MatchRunner::getCoreSize() const
+{
+	return owner_.size();
+}
+
+bool MatchRunner::isLoadedP1()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return vm_->isLoadedP1();
+}
+
+bool MatchRunner::isLoadedP2()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return vm_->isLoadedP2();
+}
+
+void MatchRunner::run()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	Clock::time_point next = Clock::now();
+
+	while(!quit_)
+	{
+		if(!steps_ && !running_)
+		{
+			wake_.wait(lock);
+
+			next = Clock::now();
+
+			continue;
+		}
+
+		bool stepping = steps_ > 0;
+		bool paced = !stepping && interval_.count();
+
+		if(paced && Clock::now() < next)
+		{
+			wake_.wait_until(lock, next);
+
+			continue;
+		}
+
+		if(stepping)
+			--steps_;
+
+		busy_ = true;
+
+		lock.unlock();
+
+		Batch batch;
+
+		execute(stepping || paced ? 1 : BatchCycles, batch);
+
+		lock.lock();
+
+		busy_ = false;
+
+		publish(batch);
+
+		if(frame_.result.state != VirtualMachine::ONGOING)
+		{
+			running_ = false;
+			steps_ = 0;
+		}
+
+		//a late cycle is not made up for by running the next ones faster
+		if(paced)
+			next = std::max(next + interval_, Clock::now());
+
+		idle_.notify_all();
+	}
+}
+
+void MatchRunner::execute(unsigned int cycles, Batch& batch)
+{
+	for(unsigned int i = 0; i < cycles && vm_->getState() == VirtualMachine::ONGOING; ++i)
+	{
+		vm_->executeCycle();
+
+		VirtualMachine::StatReport& p1 = vm_->getP1Report();
+		VirtualMachine::StatReport& p2 = vm_->getP2Report();
+
+		unsigned int cycle = vm_->getResult().cycles;
+
+		//a jump writes nothing, and player 2 does not run at all
+		//when player 1 lost on the first half of the cycle
+		if(p1.hasWritten())
+			batch.writes.emplace_back(p1.getWriteAdr(), 1);
+
+		if(p2.hasWritten())
+			batch.writes.emplace_back(p2.getWriteAdr(), 2);
+
+		if(p1.hasExecuted())
+			batch.p1Log.push(cycle, p1.getExecutedAdr(), p1.getInstruction());
+
+		if(p2.hasExecuted())
+			batch.p2Log.push(cycle, p2.getExecutedAdr(), p2.getInstruction());
+	}
+}
+
+void MatchRunner::publish(Batch& batch)
+{
+	//in execution order, so the last writer of a cell wins
+	for(const auto& write : batch.writes)
+		mark(write.first, write.second);
+
+	frame_.p1Log.append(batch.p1Log);
+	frame_.p2Log.append(batch.p2Log);
+
+	frame_.result = vm_->getResult();
+}
+
+void MatchRunner::mark(unsigned int adr, unsigned char player)
+{
+	if(!owner_[adr])
+		dirty_.push_back(adr);
+
+	owner_[adr] = player;
+}
+
+void MatchRunner::halt(std::unique_lock<std::mutex>& lock)
+{
+	running_ = false;
+	steps_ = 0;
+
+	idle_.wait(lock, [this]() { return !busy_; });
+}
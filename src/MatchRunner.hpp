@@ -0,0 +1,141 @@
+#ifndef MATCHRUNNER_HPP
+#define MATCHRUNNER_HPP
+
+#include "VirtualMachine.hpp"
+#include "InstructionLog.hpp"
+
+#include <vector>
+#include <utility>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+/*!
+ * \brief Plays a match on a worker thread
+ *
+ * start(), stop() and step() only post a request and return at once.
+ * The worker runs cycles in batches, either flat out or one cycle per
+ * interval, and after every batch merges what changed into a pending
+ * Frame, which the caller collects with takeFrame() at its own display
+ * rate. A Frame holds every cell written since the previous one exactly
+ * once, with the player that wrote it last, and the instructions
+ * executed in a bounded InstructionLog, so its size does not depend on
+ * how many cycles it covers.
+ *
+ * load() and reset() stop the match and wait for the batch in progress;
+ * the VirtualMachine is never touched by two threads at once.
+ */
+class MatchRunner
+{
+public:
+
+	using Instruction = VirtualMachine::Core::Instruction;
+
+	struct Frame
+	{
+		//cells written since the last frame, by the player who wrote them last
+		std::vector<unsigned int> p1Writes;
+		std::vector<unsigned int> p2Writes;
+
+		//instructions executed since the last frame, the newest ones if there were too many
+		InstructionLog p1Log;
+		InstructionLog p2Log;
+
+		VirtualMachine::MatchResult result;
+
+		//false once the worker has nothing left to do
+		bool running;
+	};
+
+	MatchRunner();
+
+	~MatchRunner();
+
+	void load(const std::vector<Instruction>&, unsigned int, bool = true);
+
+	void reset();
+
+	void start();
+
+	void stop();
+
+	/*!
+	 * \brief Executes one more cycle, also while the match is stopped
+	 */
+	void step();
+
+	/*!
+	 * \brief Time between two cycles while running, zero runs flat out
+	 */
+	void setInterval(std::chrono::nanoseconds);
+
+	/*!
+	 * \brief Changes since the previous call
+	 */
+	Frame takeFrame();
+
+	/*!
+	 * \brief Access counts of both players since the last reset()
+	 *
+	 * Waits for the batch in progress, without stopping the match.
+	 */
+	void copyHeatmaps(Heatmap&, Heatmap&);
+
+	unsigned int getCoreSize() const;
+
+	bool isLoadedP1();
+	bool isLoadedP2();
+
+private:
+
+	MatchRunner(const MatchRunner&) = delete;
+	MatchRunner& operator=(const MatchRunner&) = delete;
+
+	using Clock = std::chrono::steady_clock;
+
+	struct Batch
+	{
+		//written cells and their writer, in execution order
+		std::vector<std::pair<unsigned int, unsigned char>> writes;
+
+		InstructionLog p1Log;
+		InstructionLog p2Log;
+	};
+
+	void run();
+
+	void execute(unsigned int, Batch&);
+
+	void publish(Batch&);
+
+	void mark(unsigned int, unsigned char);
+
+	//stops the match, called with the mutex held
+	void halt(std::unique_lock<std::mutex>&);
+
+	std::unique_ptr<StandardVirtualMachine> vm_;
+
+	std::mutex mutex_;
+
+	std::condition_variable wake_;
+	std::condition_variable idle_;
+
+	//pending frame, writer of every cell marked in it (0 for none)
+	Frame frame_;
+	std::vector<unsigned char> owner_;
+	std::vector<unsigned int> dirty_;
+
+	std::chrono::nanoseconds interval_;
+
+	unsigned int steps_;
+
+	bool running_;
+	bool busy_;
+	bool quit_;
+
+	std::thread worker_;
+};
+
+#endif //MATCHRUNNER_HPP
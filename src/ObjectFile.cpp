@@ -0,0 +1,204 @@
+#include "ObjectFile.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+
+namespace
+{
+
+const char Magic[4] = {'C', 'W', 'O', 'B'};
+
+//reads back as 0xFFFE when the writer got the byte order wrong
+const std::uint16_t ByteOrderMark = 0xFEFF;
+
+const std::size_t CellSize = 8;
+
+bool littleEndianHost()
+{
+	const std::uint16_t one = 1;
+	unsigned char first;
+
+	std::memcpy(&first, &one, 1);
+
+	return first == 1;
+}
+
+std::uint16_t get16(const char* p)
+{
+	const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+
+	return static_cast<std::uint16_t>(u[0] | u[1] << 8);
+}
+
+std::uint32_t get32(const char* p)
+{
+	return get16(p) | static_cast<std::uint32_t>(get16(p + 2)) << 16;
+}
+
+void put16(std::string& out, std::uint16_t n)
+{
+	out += static_cast<char>(n & 0xff);
+	out += static_cast<char>(n >> 8);
+}
+
+void put32(std::string& out, std::uint32_t n)
+{
+	put16(out, static_cast<std::uint16_t>(n & 0xffff));
+	put16(out, static_cast<std::uint16_t>(n >> 16));
+}
+
+std::uint32_t checksum(const char* p, std::size_t size)
+{
+	//FNV-1a
+	std::uint32_t h = 2166136261u;
+
+	for(std::size_t i = 0; i < size; ++i)
+		h = (h ^ static_cast<unsigned char>(p[i])) * 16777619u;
+
+	return h;
+}
+
+}
+
+ObjectFile::ObjectFile(const char* fname)
+	: file_(new MappedFile(fname))
+{
+	parse(file_->data(), file_->size());
+}
+
+ObjectFile::ObjectFile(const char* data, std::size_t size)
+{
+	parse(data, size);
+}
+
+std::string ObjectFile::encode(const std::vector<Instruction>& v, unsigned int coreSize)
+{
+	if(!coreSize || coreSize > 65536)
+		throw std::invalid_argument("Object files hold core sizes between 1 and 65536");
+
+	std::string body;
+
+	body.reserve(v.size() * CellSize);
+
+	for(const auto& ins : v)
+	{
+		if(ins.aVal >= coreSize || ins.bVal >= coreSize)
+			throw std::invalid_argument("Instruction field is not normalized to the core size");
+
+		body += static_cast<char>(ins.op);
+		body += static_cast<char>(ins.mod);
+		body += static_cast<char>(ins.aMode);
+		body += static_cast<char>(ins.bMode);
+
+		put16(body, static_cast<std::uint16_t>(ins.aVal));
+		put16(body, static_cast<std::uint16_t>(ins.bVal));
+	}
+
+	std::string out(Magic, sizeof(Magic));
+
+	put16(out, Version);
+	put16(out, ByteOrderMark);
+	put32(out, v.size());
+	put32(out, coreSize);
+	put32(out, checksum(body.data(), body.size()));
+
+	out.resize(HeaderSize, '\0');
+
+	return out + body;
+}
+
+void ObjectFile::write(const char* fname, const std::vector<Instruction>& v, unsigned int coreSize)
+{
+	std::string image = encode(v, coreSize);
+
+	std::ofstream fout(fname, std::ofstream::out |
+					   std::ofstream::binary |
+					   std::ofstream::trunc);
+
+	fout.write(image.data(), image.size());
+
+	if(!fout)
+		throw std::runtime_error(std::string("Cannot write ") + fname);
+}
+
+unsigned int ObjectFile::size() const
+{
+	return count_;
+}
+
+unsigned int ObjectFile::getCoreSize() const
+{
+	return coreSize_;
+}
+
+auto ObjectFile::data() const -> const PackedInstruction*
+{
+	return body_;
+}
+
+auto ObjectFile::getInstructions() const -> std::vector<Instruction>
+{
+	return std::vector<Instruction>(body_, body_ + count_);
+}
+
+void ObjectFile::parse(const char* data, std::size_t size)
+{
+	static_assert(sizeof(PackedInstruction) == CellSize, "PackedInstruction has to match the object file cell");
+
+	if(size < HeaderSize || std::memcmp(data, Magic, sizeof(Magic)))
+		throw std::runtime_error("Not an object file");
+
+	if(get16(data + 4) != Version)
+		throw std::runtime_error("Unsupported object file version");
+
+	if(get16(data + 6) != ByteOrderMark)
+		throw std::runtime_error("Object file has the wrong byte order");
+
+	count_ = get32(data + 8);
+	coreSize_ = get32(data + 12);
+
+	if(!coreSize_ || coreSize_ > 65536)
+		throw std::runtime_error("Object file has an invalid core size");
+
+	if((size - HeaderSize) / CellSize != count_ || (size - HeaderSize) % CellSize)
+		throw std::runtime_error("Object file is truncated");
+
+	const char* body = data + HeaderSize;
+
+	if(checksum(body, count_ * CellSize) != get32(data + 16))
+		throw std::runtime_error("Object file checksum mismatch");
+
+	for(unsigned int i = 0; i < count_; ++i)
+	{
+		const char* cell = body + i * CellSize;
+
+		if(static_cast<unsigned char>(cell[0]) > Instruction::BLT ||
+				static_cast<unsigned char>(cell[1]) > Instruction::I ||
+				static_cast<unsigned char>(cell[2]) > Instruction::BIN ||
+				static_cast<unsigned char>(cell[3]) > Instruction::BIN ||
+				get16(cell + 4) >= coreSize_ || get16(cell + 6) >= coreSize_)
+			throw std::runtime_error("Object file holds an invalid instruction");
+	}
+
+	if(littleEndianHost() && !(reinterpret_cast<std::uintptr_t>(body) % alignof(PackedInstruction)))
+		body_ = reinterpret_cast<const PackedInstruction*>(body);
+
+	else
+	{
+		copy_.reserve(count_);
+
+		for(unsigned int i = 0; i < count_; ++i)
+		{
+			const char* cell = body + i * CellSize;
+
+			copy_.push_back(Instruction(static_cast<Instruction::OpCode>(cell[0]),
+										   static_cast<Instruction::Modifier>(cell[1]),
+										   get16(cell + 4), get16(cell + 6),
+										   static_cast<Instruction::AddressMode>(cell[2]),
+										   static_cast<Instruction::AddressMode>(cell[3])));
+		}
+
+		body_ = copy_.data();
+	}
+}
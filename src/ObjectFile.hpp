@@ -0,0 +1,80 @@
+#ifndef OBJECTFILE_HPP
+#define OBJECTFILE_HPP
+
+#include "VirtualMachine.hpp"
+#include "MappedFile.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*!
+ * \brief Compiled warrior, as written by Assembler::toFile()
+ *
+ * Little-endian layout: a 32 byte header (magic "CWOB", version,
+ * byte order marker, instruction count, core size the fields are
+ * normalized to and an FNV-1a checksum of the body) followed by one
+ * 8 byte PackedInstruction per instruction. Field values therefore
+ * have to be below 65536.
+ *
+ * The image is validated once when the ObjectFile is created; on a
+ * little-endian host data() then points straight into the mapping,
+ * ready for BasicVirtualMachine::loadProgram to copy in bulk. Big-endian
+ * hosts and misaligned images get a decoded copy instead.
+ * Invalid images throw std::runtime_error.
+ */
+class ObjectFile
+{
+public:
+
+	using Instruction = VirtualMachineBase::Instruction;
+	using PackedInstruction = VirtualMachineBase::PackedInstruction;
+
+	static constexpr std::uint16_t Version = 1;
+
+	static constexpr std::size_t HeaderSize = 32;
+
+	/*!
+	 * \brief Maps and validates the given file
+	 */
+	explicit ObjectFile(const char*);
+
+	/*!
+	 * \brief Validates an image owned by the caller, which has to outlive the ObjectFile
+	 */
+	ObjectFile(const char*, std::size_t);
+
+	/*!
+	 * \brief Image of the given instructions, throws std::invalid_argument if a field does not fit
+	 */
+	static std::string encode(const std::vector<Instruction>&, unsigned int = 8000);
+
+	static void write(const char*, const std::vector<Instruction>&, unsigned int = 8000);
+
+	unsigned int size() const;
+
+	unsigned int getCoreSize() const;
+
+	const PackedInstruction* data() const;
+
+	std::vector<Instruction> getInstructions() const;
+
+private:
+
+	void parse(const char*, std::size_t);
+
+	std::unique_ptr<MappedFile> file_;
+
+	//host order copy of the body, when it cannot be used in place
+	std::vector<PackedInstruction> copy_;
+
+	const PackedInstruction* body_;
+
+	unsigned int count_;
+
+	unsigned int coreSize_;
+};
+
+#endif //OBJECTFILE_HPP
@@ -0,0 +1,114 @@
+#include "SymbolTable.hpp"
+
+#include "Lexer.hpp"
+
+namespace
+{
+
+const std::size_t InitialSlots = 64;
+
+}
+
+SymbolTable::SymbolTable() : slots_(InitialSlots, 0)
+{}
+
+unsigned int SymbolTable::intern(std::string_view name)
+{
+	std::size_t h = hash(name);
+	std::size_t i = probe(name, h);
+
+	if(slots_[i])
+		return slots_[i] - 1;
+
+	//kept at most half full, so probing always reaches an empty slot
+	if(2 * (symbols_.size() + 1) > slots_.size())
+	{
+		grow();
+
+		i = probe(name, h);
+	}
+
+	symbols_.push_back(Symbol{name, h, Undefined});
+
+	slots_[i] = symbols_.size();
+
+	return symbols_.size() - 1;
+}
+
+bool SymbolTable::define(unsigned int id, int value)
+{
+	if(symbols_[id].value != Undefined)
+		return false;
+
+	symbols_[id].value = value;
+
+	return true;
+}
+
+int SymbolTable::value(unsigned int id) const
+{
+	return symbols_[id].value;
+}
+
+std::size_t SymbolTable::size() const
+{
+	return symbols_.size();
+}
+
+std::size_t SymbolTable::hash(std::string_view name)
+{
+	//FNV-1a
+	std::size_t h = 14695981039346656037ull;
+
+	for(char c : name)
+		h = (h ^ static_cast<unsigned char>(Lexer::lower(c))) * 1099511628211ull;
+
+	return h;
+}
+
+bool SymbolTable::equals(std::string_view a, std::string_view b)
+{
+	if(a.size() != b.size())
+		return false;
+
+	for(std::size_t i = 0; i < a.size(); ++i)
+		if(Lexer::lower(a[i]) != Lexer::lower(b[i]))
+			return false;
+
+	return true;
+}
+
+std::size_t SymbolTable::probe(std::string_view name, std::size_t h) const
+{
+	std::size_t mask = slots_.size() - 1;
+	std::size_t i = h & mask;
+
+	while(slots_[i])
+	{
+		const Symbol& s = symbols_[slots_[i] - 1];
+
+		if(s.hash == h && equals(s.name, name))
+			break;
+
+		i = (i + 1) & mask;
+	}
+
+	return i;
+}
+
+void SymbolTable::grow()
+{
+	slots_.assign(2 * slots_.size(), 0);
+
+	std::size_t mask = slots_.size() - 1;
+
+	for(unsigned int id = 0; id < symbols_.size(); ++id)
+	{
+		std::size_t i = symbols_[id].hash & mask;
+
+		while(slots_[i])
+			i = (i + 1) & mask;
+
+		slots_[i] = id + 1;
+	}
+}
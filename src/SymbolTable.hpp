@@ -0,0 +1,61 @@
+#ifndef SYMBOLTABLE_HPP
+#define SYMBOLTABLE_HPP
+
+#include <vector>
+#include <string_view>
+#include <cstddef>
+
+/*!
+ * \brief Open-addressing table of labels, compared case-insensitively
+ *
+ * A label is hashed and probed once, by intern(), which returns a dense
+ * id; definitions and references then go through the id. Names are
+ * views into the source, which has to outlive the table.
+ */
+class SymbolTable
+{
+public:
+
+	static constexpr int Undefined = -1;
+
+	SymbolTable();
+
+	unsigned int intern(std::string_view);
+
+	/*!
+	 * \brief Gives the symbol a value, false if it already had one
+	 */
+	bool define(unsigned int, int);
+
+	int value(unsigned int) const;
+
+	std::size_t size() const;
+
+private:
+
+	struct Symbol
+	{
+		std::string_view name;
+
+		std::size_t hash;
+
+		int value;
+	};
+
+	static std::size_t hash(std::string_view);
+
+	static bool equals(std::string_view, std::string_view);
+
+	//slot holding the name, or the empty slot it would be inserted in
+	std::size_t probe(std::string_view, std::size_t) const;
+
+	void grow();
+
+	//indexed by id
+	std::vector<Symbol> symbols_;
+
+	//id + 1 per slot, 0 when empty; the size is a power of two
+	std::vector<unsigned int> slots_;
+};
+
+#endif //SYMBOLTABLE_HPP
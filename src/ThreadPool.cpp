@@ -0,0 +1,149 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(unsigned int threads)
+	: queued_(0),
+	  pending_(0),
+	  next_(0),
+	  stop_(false)
+{
+	if(!threads)
+		threads = 1;
+
+	for(unsigned int i = 0; i < threads; ++i)
+		queues_.emplace_back(new WorkQueue);
+
+	for(unsigned int i = 0; i < threads; ++i)
+		threads_.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		stop_ = true;
+	}
+
+	wake_.notify_all();
+
+	for(auto& t : threads_)
+		t.join();
+}
+
+unsigned int ThreadPool::size() const
+{
+	return threads_.size();
+}
+
+void ThreadPool::submit(Task task)
+{
+	WorkQueue& queue = *queues_[next_];
+
+	if(++next_ == queues_.size())
+		next_ = 0;
+
+	++pending_;
+
+	//counted first, so a thief taking the task cannot wrap the counter
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		++queued_;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		queue.tasks.push_back(std::move(task));
+	}
+
+	wake_.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	idle_.wait(lock, [this]() { return !pending_; });
+
+	if(error_)
+	{
+		std::exception_ptr error = error_;
+
+		error_ = nullptr;
+
+		std::rethrow_exception(error);
+	}
+}
+
+void ThreadPool::run(unsigned int index)
+{
+	for(;;)
+	{
+		Task task;
+
+		if(take(index, task))
+		{
+			try
+			{
+				task(index);
+			}
+
+			catch(...)
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+
+				if(!error_)
+					error_ = std::current_exception();
+			}
+
+			if(!--pending_)
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+
+				idle_.notify_all();
+			}
+
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		wake_.wait(lock, [this]() { return stop_ || queued_; });
+
+		if(stop_ && !queued_)
+			return;
+	}
+}
+
+bool ThreadPool::take(unsigned int index, Task& task)
+{
+	//newest task of the own queue first, then the oldest task of another
+	for(unsigned int i = 0; i < queues_.size(); ++i)
+	{
+		WorkQueue& queue = *queues_[(index + i) % queues_.size()];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if(queue.tasks.empty())
+			continue;
+
+		if(!i)
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+
+		else
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+
+		--queued_;
+
+		return true;
+	}
+
+	return false;
+}
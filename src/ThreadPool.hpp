@@ -0,0 +1,80 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+/*!
+ * \brief Fixed set of worker threads with per-worker task queues
+ *
+ * Submitted tasks are dealt round-robin to the workers' queues. A worker
+ * takes tasks from the back of its own queue and, once that is empty,
+ * steals from the front of the others. Tasks receive the index of the
+ * worker running them, so callers can keep per-worker state such as a
+ * VirtualMachine and reuse it across tasks.
+ *
+ * The first exception thrown by a task is rethrown from wait().
+ */
+class ThreadPool
+{
+public:
+
+	using Task = std::function<void(unsigned int)>;
+
+	explicit ThreadPool(unsigned int = std::thread::hardware_concurrency());
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned int size() const;
+
+	void submit(Task);
+
+	/*!
+	 * \brief Blocks until every submitted task has finished
+	 */
+	void wait();
+
+private:
+
+	struct WorkQueue
+	{
+		std::mutex mutex;
+
+		std::deque<Task> tasks;
+	};
+
+	void run(unsigned int);
+
+	bool take(unsigned int, Task&);
+
+	std::vector<std::unique_ptr<WorkQueue>> queues_;
+
+	std::vector<std::thread> threads_;
+
+	std::mutex mutex_;
+
+	std::condition_variable wake_;
+	std::condition_variable idle_;
+
+	//tasks sitting in a queue and tasks not yet finished
+	std::atomic<unsigned int> queued_;
+	std::atomic<unsigned int> pending_;
+
+	unsigned int next_;
+
+	bool stop_;
+
+	std::exception_ptr error_;
+};
+
+#endif //THREADPOOL_HPP
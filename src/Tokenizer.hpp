@@ -1,18 +1,20 @@
 #ifndef TOKENIZER_HPP
 #define TOKENIZER_HPP
 
-#include <vector>
-#include <boost/tokenizer.hpp>
+#include "Lexer.hpp"
+
+#include <string>
 
 /*!
- * \brief The Tokenizer class
+ * \brief Owning, std::string based front end of Lexer
+ *
+ * Keeps a copy of the assigned text and returns every token as a new
+ * string, lowercased on request. Hot paths should use Lexer directly.
  */
 class Tokenizer
 {
 public:
 
-	Tokenizer();
-
 	Tokenizer(const std::string&,
 			  const char*,
 			  const char* = "",
@@ -26,33 +28,15 @@ public:
 
 private:
 
-	std::string toLCase(const std::string&);
-
-	void nextToken();
-
-	bool checkToken();
-
-	//boost::char_separator<char> sep_;
+	//lexer_ points into text_
+	Tokenizer(const Tokenizer&) = delete;
+	Tokenizer& operator=(const Tokenizer&) = delete;
 
 	std::string text_;
 
-	std::string::const_iterator strit_;
-
-	std::vector<std::string> tokens_;
-
-	unsigned int index_;
-
-	std::string dropped_;
-
-	std::string kept_;
+	Lexer lexer_;
 
 	bool forceLowercase_;
-
-	bool processed_;
-
-	//boost::tokenizer< boost::char_separator<char> > t_;
-
-	//boost::tokenizer< boost::char_separator<char> >::iterator it_;
 };
 
 #endif //TOKENIZER_HPP
@@ -0,0 +1,162 @@
+#include "Tournament.hpp"
+
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+
+//ICWS'94 MAXLENGTH and MINDISTANCE
+const unsigned int MaxLength = 100;
+const unsigned int MinDistance = 100;
+
+}
+
+Tournament::Tournament(unsigned int rounds, unsigned int seed, unsigned int threads)
+	: rounds_(rounds),
+	  seed_(seed),
+	  profiling_(false),
+	  pool_(threads)
+{
+	for(unsigned int i = 0; i < pool_.size(); ++i)
+		machines_.emplace_back(new HeadlessVirtualMachine);
+}
+
+unsigned int Tournament::addWarrior(const std::vector<Instruction>& warrior)
+{
+	if(warrior.empty() || warrior.size() > MaxLength)
+		throw std::invalid_argument("Warrior length has to be between 1 and 100 instructions");
+
+	warriors_.push_back(warrior);
+
+	return warriors_.size() - 1;
+}
+
+unsigned int Tournament::getWarriorCount() const
+{
+	return warriors_.size();
+}
+
+void Tournament::run()
+{
+	unsigned int count = warriors_.size();
+
+	scores_.assign(count, std::vector<Score>(count));
+
+	profile_.reset();
+
+	if(profiling_)
+		for(unsigned int i = profiled_.size(); i < pool_.size(); ++i)
+			profiled_.emplace_back(new ProfiledVirtualMachine);
+
+	for(auto& vm : profiled_)
+	{
+		vm->getP1Report().reset();
+		vm->getP2Report().reset();
+	}
+
+	//one slot per round, written by exactly one task
+	std::vector<VirtualMachine::RoundState> results(count * count * rounds_);
+
+	for(unsigned int a = 0; a < count; ++a)
+		for(unsigned int b = a + 1; b < count; ++b)
+			for(unsigned int r = 0; r < rounds_; ++r)
+			{
+				VirtualMachine::RoundState& result = results[(a * count + b) * rounds_ + r];
+
+				if(profiling_)
+					pool_.submit([this, &result, a, b, r](unsigned int worker)
+					{
+						result = play(*profiled_[worker], a, b, r);
+					});
+				else
+					pool_.submit([this, &result, a, b, r](unsigned int worker)
+					{
+						result = play(*machines_[worker], a, b, r);
+					});
+			}
+
+	pool_.wait();
+
+	if(profiling_)
+		for(const auto& vm : profiled_)
+		{
+			profile_ += vm->getP1Report();
+			profile_ += vm->getP2Report();
+		}
+
+	for(unsigned int a = 0; a < count; ++a)
+		for(unsigned int b = a + 1; b < count; ++b)
+			for(unsigned int r = 0; r < rounds_; ++r)
+			{
+				switch(results[(a * count + b) * rounds_ + r])
+				{
+				case VirtualMachine::P1_WON:
+					++scores_[a][b].wins;
+					++scores_[b][a].losses;
+					break;
+
+				case VirtualMachine::P2_WON:
+					++scores_[a][b].losses;
+					++scores_[b][a].wins;
+					break;
+
+				default:
+					++scores_[a][b].draws;
+					++scores_[b][a].draws;
+					break;
+				}
+			}
+}
+
+const Tournament::Score& Tournament::getScore(unsigned int a, unsigned int b) const
+{
+	return scores_.at(a).at(b);
+}
+
+const std::vector<std::vector<Tournament::Score>>& Tournament::getScores() const
+{
+	return scores_;
+}
+
+void Tournament::setProfiling(bool profiling)
+{
+	profiling_ = profiling;
+}
+
+bool Tournament::isProfiling() const
+{
+	return profiling_;
+}
+
+const VirtualMachine::ProfileReport& Tournament::getProfile() const
+{
+	return profile_;
+}
+
+//plays one round on the worker's machine, the result is given as if
+//warrior a was always player 1
+template<class VM>
+VirtualMachine::RoundState Tournament::play(VM& vm, unsigned int a, unsigned int b, unsigned int round)
+{
+	std::seed_seq seq = {seed_, a, b, round};
+	std::mt19937 rng(seq);
+
+	unsigned int distance = MinDistance + rng() % (vm.getCoreSize() - 2 * MinDistance + 1);
+
+	bool swapped = round % 2;
+
+	vm.reset();
+	vm.loadProgram(warriors_[swapped ? b : a], 0);
+	vm.loadProgram(warriors_[swapped ? a : b], distance, false);
+
+	VirtualMachine::RoundState state = vm.runToCompletion().state;
+
+	if(swapped && state == VirtualMachine::P1_WON)
+		return VirtualMachine::P2_WON;
+
+	if(swapped && state == VirtualMachine::P2_WON)
+		return VirtualMachine::P1_WON;
+
+	return state;
+}
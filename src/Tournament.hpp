@@ -0,0 +1,90 @@
+#ifndef TOURNAMENT_HPP
+#define TOURNAMENT_HPP
+
+#include "VirtualMachine.hpp"
+#include "ThreadPool.hpp"
+
+#include <vector>
+#include <memory>
+#include <thread>
+
+/*!
+ * \brief Round-robin tournament between assembled warriors
+ *
+ * Every pair of warriors meets for a given number of rounds. Rounds are
+ * scheduled as separate tasks on a work-stealing ThreadPool and each
+ * worker reuses a single HeadlessVirtualMachine. Placement is derived
+ * from the seed, the pair and the round only, and players swap sides
+ * every round, so results do not depend on the number of threads.
+ *
+ * With profiling enabled the rounds run on ProfiledVirtualMachine
+ * instead and the reports of both players of every round are merged
+ * into a single profile.
+ */
+class Tournament
+{
+public:
+
+	using Instruction = VirtualMachine::Core::Instruction;
+
+	struct Score
+	{
+		unsigned int wins = 0;
+		unsigned int losses = 0;
+		unsigned int draws = 0;
+	};
+
+	Tournament(unsigned int = 1, unsigned int = 0,
+			   unsigned int = std::thread::hardware_concurrency());
+
+	/*!
+	 * \brief Adds a warrior and returns its index in the score matrix
+	 */
+	unsigned int addWarrior(const std::vector<Instruction>&);
+
+	unsigned int getWarriorCount() const;
+
+	void run();
+
+	/*!
+	 * \brief Score of the first warrior against the second
+	 */
+	const Score& getScore(unsigned int, unsigned int) const;
+
+	const std::vector<std::vector<Score>>& getScores() const;
+
+	void setProfiling(bool);
+
+	bool isProfiling() const;
+
+	/*!
+	 * \brief Paths taken by all rounds of the last run(), empty unless profiling
+	 */
+	const VirtualMachine::ProfileReport& getProfile() const;
+
+private:
+
+	template<class VM>
+	VirtualMachine::RoundState play(VM&, unsigned int, unsigned int, unsigned int);
+
+	unsigned int rounds_;
+
+	unsigned int seed_;
+
+	std::vector<std::vector<Instruction>> warriors_;
+
+	std::vector<std::vector<Score>> scores_;
+
+	std::vector<std::unique_ptr<HeadlessVirtualMachine>> machines_;
+
+	//created on the first profiled run
+	std::vector<std::unique_ptr<ProfiledVirtualMachine>> profiled_;
+
+	bool profiling_;
+
+	VirtualMachine::ProfileReport profile_;
+
+	ThreadPool pool_;
+};
+
+#endif //TOURNAMENT_HPP
@@ -1,56 +1,263 @@
 #include "VirtualMachine.hpp"
+#include "ObjectFile.hpp"
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <stdexcept>
 #include <cstddef>
+#include <algorithm>
+#include <cstring>
 
-typedef VirtualMachine::Core Core;
-typedef VirtualMachine::StatReport StatReport;
-typedef VirtualMachine::Core::ProgramPtr ProgramPtr;
-typedef VirtualMachine::Core::Instruction Instruction;
+typedef VirtualMachineBase::StatReport StatReport;
+typedef VirtualMachineBase::HeatmapReport HeatmapReport;
+typedef VirtualMachineBase::ProfileReport ProfileReport;
+typedef VirtualMachineBase::Instruction Instruction;
 
-typedef VirtualMachine::Core::Instruction::OpCode OpCode;
-typedef VirtualMachine::Core::Instruction::Modifier Modifier;
-typedef VirtualMachine::Core::Instruction::AddressMode AddressMode;
+typedef Instruction::OpCode OpCode;
+typedef Instruction::Modifier Modifier;
+typedef Instruction::AddressMode AddressMode;
 
-std::string VirtualMachine::StatReport::op[] = {"KIL", "FRK", "NOP", "MOV", "ADD", "SUB", "MUL", "DIV", "MOD", "JMP"};
-std::string VirtualMachine::StatReport::mod[] = {"A", "B", "AB", "BA", "F", "X", "I"};
-std::string VirtualMachine::StatReport::address[] = {"#", "$", "*", "@"};
+std::string StatReport::op[] = {"KIL", "FRK", "NOP", "MOV", "ADD", "SUB", "MUL", "DIV", "MOD", "JMP",
+								"JMZ", "JMN", "BEQ", "BNE", "BLT"};
+std::string StatReport::mod[] = {"A", "B", "AB", "BA", "F", "X", "I"};
+std::string StatReport::address[] = {"#", "$", "*", "@"};
 
-StatReport::RoundState StatReport::state_ = StatReport::ONGOING;
+namespace
+{
+
+//only a StatReport and a HeatmapReport keep per-cell counts
+template<class Report>
+void sizeReport(Report&, unsigned int) {}
+
+void sizeReport(StatReport& report, unsigned int size)
+{
+	report.setCoreSize(size);
+}
+
+void sizeReport(HeatmapReport& report, unsigned int size)
+{
+	report.setCoreSize(size);
+}
+
+}
 
-VirtualMachine::VirtualMachine(unsigned int coresize)
-	: core_(coresize),
-	  maxCycles_(20000),
-	  maxProcesses_(64),
+template<class Rules, class Report>
+BasicVirtualMachine<Rules, Report>::BasicVirtualMachine(unsigned int coresize, Engine engine)
+	: maxCycles_(Rules::maxCycles ? Rules::maxCycles : 20000),
+	  maxProcesses_(Rules::maxProcesses ? Rules::maxProcesses : 64),
+	  p1_(maxProcesses_),
+	  p2_(maxProcesses_),
+	  core_(coresize),
+	  engine_(engine),
+	  currentCycle_(0),
+	  state_(ONGOING),
 	  loaded_p1_(false),
 	  loaded_p2_(false)
 {
+	initStorage(decoded_, coresize, DecodedCell());
 
+	//nothing is shared before the first snapshot, every page has to be copied
+	unsigned int pages = (core_.getSize() + PageCells - 1) / PageCells;
+
+	pages_.assign(pages, nullptr);
+	initStorage(dirty_, pages, static_cast<unsigned char>(1));
+
+	sizeReport(p1Report_, coresize);
+	sizeReport(p2Report_, coresize);
+}
+
+template<class Rules, class Report>
+template<class T>
+void BasicVirtualMachine<Rules, Report>::initStorage(std::vector<T>& v, unsigned int size, const T& value)
+{
+	v.assign(size, value);
 }
 
-void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
+template<class Rules, class Report>
+template<class T, std::size_t N>
+void BasicVirtualMachine<Rules, Report>::initStorage(std::array<T, N>& a, unsigned int, const T& value)
+{
+	a.fill(value);
+}
+
+namespace
+{
+
+//instruction fields read from the executed cell on every cycle
+template<class ProgramPtr>
+struct DynamicDecoding
+{
+	template<class Cell>
+	explicit DynamicDecoding(const Cell& ins)
+		: op(ins.op), mod(ins.mod),
+		  aVal(ins.aVal), bVal(ins.bVal) {}
+
+	ProgramPtr aPointer(ProgramPtr p) const
+	{
+		return p + aVal;
+	}
+
+	ProgramPtr bPointer(ProgramPtr p) const
+	{
+		return p + bVal;
+	}
+
+	static constexpr bool cached = false;
+
+	OpCode op;
+	Modifier mod;
+
+	unsigned int aVal;
+	unsigned int bVal;
+};
+
+//opcode and modifier fixed at compile time, lets the compiler drop
+//every branch of execute() that does not apply to the handler;
+//the cells addressed by the A and B fields come from the decode cache
+template<class ProgramPtr, OpCode O, Modifier M>
+struct StaticDecoding
+{
+	StaticDecoding(ProgramPtr a, ProgramPtr b) : a_(a), b_(b) {}
+
+	ProgramPtr aPointer(ProgramPtr) const
+	{
+		return a_;
+	}
+
+	ProgramPtr bPointer(ProgramPtr) const
+	{
+		return b_;
+	}
+
+	static constexpr bool cached = true;
+
+	static constexpr OpCode op = O;
+	static constexpr Modifier mod = M;
+
+	ProgramPtr a_;
+	ProgramPtr b_;
+};
+
+}
+
+template<class Rules, class Report>
+void BasicVirtualMachine<Rules, Report>::executeInstruction(ProcessQueue& proc, Report& report)
 {
 	if(proc.empty())
 		throw std::runtime_error("Attempted to obtain process from an empty ProcessQueue");
 
-	//static std::string op[] = {"KIL", "FRK", "NOP", "MOV", "ADD", "SUB", "MUL", "DIV", "MOD", "JMP"};
-	//static std::string mod[] = {"A", "B", "AB", "BA", "F", "X", "I"};
-	//static std::string address[] = {"#", "$", "*", "@"};
+	report.phase(FETCH);
 
-	ProgramPtr p = proc.front();
+	ProgramPtr p = core_.at(proc.front());
 	proc.pop();
 
+	if(engine_ == PREDECODED)
+	{
+		Handler handler = decoded_[p.pos()].handler;
+
+		if(!handler)
+			handler = decode(p);
+
+		handler(*this, proc, report, p);
+	}
+
+	else
+		execute(DynamicDecoding<ProgramPtr>(*p), proc, report, p);
+
+	report.phase(IDLE);
+}
+
+template<class Rules, class Report>
+template<OpCode O, Modifier M>
+void BasicVirtualMachine<Rules, Report>::executeDecoded(BasicVirtualMachine& vm, ProcessQueue& proc, Report& report, ProgramPtr p)
+{
+	const DecodedCell& cell = vm.decoded_[p.pos()];
+
+	vm.execute(StaticDecoding<ProgramPtr, O, M>(vm.core_.at(cell.aTarget), vm.core_.at(cell.bTarget)),
+			   proc, report, p);
+}
+
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::decode(ProgramPtr p) -> Handler
+{
+	DecodedCell& cell = decoded_[p.pos()];
+
+	cell.aTarget = (p + p->aVal).pos();
+	cell.bTarget = (p + p->bVal).pos();
+
+	return cell.handler = selectHandler(*p);
+}
+
+#define COREWAR_SELECT_MOD(o, m) \
+	case Modifier::m: \
+		return &BasicVirtualMachine::executeDecoded<OpCode::o, Modifier::m>;
+
+#define COREWAR_SELECT_OP(o) \
+	case OpCode::o: \
+		switch(ins.mod) \
+		{ \
+		COREWAR_SELECT_MOD(o, A) \
+		COREWAR_SELECT_MOD(o, B) \
+		COREWAR_SELECT_MOD(o, AB) \
+		COREWAR_SELECT_MOD(o, BA) \
+		COREWAR_SELECT_MOD(o, F) \
+		COREWAR_SELECT_MOD(o, X) \
+		COREWAR_SELECT_MOD(o, I) \
+		} \
+		break;
+
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::selectHandler(const Cell& ins) -> Handler
+{
+	switch(ins.op)
+	{
+	COREWAR_SELECT_OP(KIL)
+	COREWAR_SELECT_OP(FRK)
+	COREWAR_SELECT_OP(NOP)
+	COREWAR_SELECT_OP(MOV)
+	COREWAR_SELECT_OP(ADD)
+	COREWAR_SELECT_OP(SUB)
+	COREWAR_SELECT_OP(MUL)
+	COREWAR_SELECT_OP(DIV)
+	COREWAR_SELECT_OP(MOD)
+	COREWAR_SELECT_OP(JMP)
+	COREWAR_SELECT_OP(JMZ)
+	COREWAR_SELECT_OP(JMN)
+	COREWAR_SELECT_OP(BEQ)
+	COREWAR_SELECT_OP(BNE)
+	COREWAR_SELECT_OP(BLT)
+	}
+
+	throw std::invalid_argument("Attempted to decode an invalid instruction");
+}
+
+#undef COREWAR_SELECT_OP
+#undef COREWAR_SELECT_MOD
+
+template<class Rules, class Report>
+template<bool Cached>
+inline void BasicVirtualMachine<Rules, Report>::written(unsigned int adr)
+{
+	if constexpr(Cached)
+		decoded_[adr].handler = nullptr;
+
+	dirty_[adr / PageCells] = 1;
+}
+
+template<class Rules, class Report>
+template<class Decoded>
+void BasicVirtualMachine<Rules, Report>::execute(const Decoded& decoded, ProcessQueue& proc, Report& report, ProgramPtr p)
+{
 	ProgramPtr ps = p;
 	ProgramPtr pd = p;
 
 	//instruction "registers"
-	Instruction current = *p;
-	Instruction src, dst;
+	Cell current = *p;
+	Cell src, dst;
 
 	report.exec(p.pos(), current);
+	report.phase(OPERANDS);
 
 	//std::cout << op[current.op] << "." << mod[current.mod] << "\t"
 	//		  << address[current.aMode] << current.aVal << "\t"
@@ -63,19 +270,19 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 		break;
 
 	case AddressMode::DIR:
-		ps = p + current.aVal;
+		ps = decoded.aPointer(p);
 		break;
 
 	case AddressMode::AIN:
 	{
-		ProgramPtr tmp = p + current.aVal;
+		ProgramPtr tmp = decoded.aPointer(p);
 		ps = tmp + tmp->aVal;
 		break;
 	}
 
 	case AddressMode::BIN:
 	{
-		ProgramPtr tmp = p + current.aVal;
+		ProgramPtr tmp = decoded.aPointer(p);
 		ps = tmp + tmp->bVal;
 		break;
 	}
@@ -90,19 +297,19 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 			break;
 
 		case AddressMode::DIR:
-			pd = p + current.bVal;
+			pd = decoded.bPointer(p);
 			break;
 
 		case AddressMode::AIN:
 		{
-			ProgramPtr tmp = p + current.bVal;
+			ProgramPtr tmp = decoded.bPointer(p);
 			pd = tmp + tmp->aVal;
 			break;
 		}
 
 		case AddressMode::BIN:
 		{
-			ProgramPtr tmp = p + current.bVal;
+			ProgramPtr tmp = decoded.bPointer(p);
 			pd = tmp + tmp->bVal;
 			break;
 		}
@@ -110,8 +317,10 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 
 	dst = *pd;
 
+	report.phase(EXECUTE);
+
 	//execute current instruction
-	switch(current.op)
+	switch(decoded.op)
 	{
 	case OpCode::KIL:
 		report.killProcess();
@@ -119,7 +328,7 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 
 	case OpCode::FRK:
 		proc.push(++p);
-		if(proc.size() < maxProcesses_)
+		if(proc.size() < getMaxProcesses())
 		{
 			proc.push(ps);
 			report.createProcess();
@@ -131,7 +340,7 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 		break;
 
 	case OpCode::MOV:
-		switch(current.mod)
+		switch(decoded.mod)
 		{
 		case Modifier::A:
 			pd->aVal = src.aVal;
@@ -163,111 +372,116 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 			*pd = src;
 			break;
 		}
+		written<Decoded::cached>(pd.pos());
 		report.read(ps.pos());
 		report.write(pd.pos());
 		proc.push(++p);
 		break;
 
 	case OpCode::ADD:
-		switch (current.mod)
+		switch (decoded.mod)
 		{
 		case Modifier::A:
-			pd->aVal = (dst.aVal + src.aVal) % core_.size_;
+			pd->aVal = core_.wrap(dst.aVal + src.aVal);
 			break;
 
 		case Modifier::B:
-			pd->bVal = (dst.bVal + src.bVal) % core_.size_;
+			pd->bVal = core_.wrap(dst.bVal + src.bVal);
 			break;
 
 		case Modifier::AB:
-			pd->bVal = (dst.bVal + src.aVal) % core_.size_;
+			pd->bVal = core_.wrap(dst.bVal + src.aVal);
 			break;
 
 		case Modifier::BA:
-			pd->aVal = (dst.aVal + src.bVal) % core_.size_;
+			pd->aVal = core_.wrap(dst.aVal + src.bVal);
 			break;
 
 		case Modifier::X:
-			pd->aVal = (dst.aVal + src.bVal) % core_.size_;
-			pd->bVal = (dst.bVal + src.aVal) % core_.size_;
+			pd->aVal = core_.wrap(dst.aVal + src.bVal);
+			pd->bVal = core_.wrap(dst.bVal + src.aVal);
 			break;
 
 		case Modifier::F:
 		case Modifier::I:
-			pd->aVal = (dst.aVal + src.aVal) % core_.size_;
-			pd->bVal = (dst.bVal + src.bVal) % core_.size_;
+			pd->aVal = core_.wrap(dst.aVal + src.aVal);
+			pd->bVal = core_.wrap(dst.bVal + src.bVal);
 			break;
 		}
+		written<Decoded::cached>(pd.pos());
 		report.read(ps.pos());
 		report.write(pd.pos());
 		proc.push(++p);
 		break;
 
 	case OpCode::SUB:
-		switch(current.mod)
+		switch(decoded.mod)
 		{
 		case Modifier::A:
-			pd->aVal = (core_.size_ + dst.aVal - src.aVal) % core_.size_;
+			pd->aVal = core_.wrap(core_.getSize() + dst.aVal - src.aVal);
 			break;
 
 		case Modifier::B:
-			pd->bVal = (core_.size_ + dst.bVal - src.bVal) % core_.size_;
+			pd->bVal = core_.wrap(core_.getSize() + dst.bVal - src.bVal);
 			break;
 
 		case Modifier::AB:
-			pd->bVal = (core_.size_ + dst.bVal - src.aVal) % core_.size_;
+			pd->bVal = core_.wrap(core_.getSize() + dst.bVal - src.aVal);
 			break;
 
 		case Modifier::BA:
-			pd->aVal = (core_.size_ + dst.aVal - src.bVal) % core_.size_;
+			pd->aVal = core_.wrap(core_.getSize() + dst.aVal - src.bVal);
 			break;
 
 		case Modifier::X:
-			pd->aVal = (core_.size_ + dst.aVal - src.bVal) % core_.size_;
-			pd->bVal = (core_.size_ + dst.bVal - src.aVal) % core_.size_;
+			pd->aVal = core_.wrap(core_.getSize() + dst.aVal - src.bVal);
+			pd->bVal = core_.wrap(core_.getSize() + dst.bVal - src.aVal);
 			break;
 
 		case Modifier::F:
 		case Modifier::I:
-			pd->aVal = (core_.size_ + dst.aVal - src.aVal) % core_.size_;
-			pd->bVal = (core_.size_ + dst.bVal - src.bVal) % core_.size_;
+			pd->aVal = core_.wrap(core_.getSize() + dst.aVal - src.aVal);
+			pd->bVal = core_.wrap(core_.getSize() + dst.bVal - src.bVal);
 			break;
 		}
+		written<Decoded::cached>(pd.pos());
 		report.read(ps.pos());
 		report.write(pd.pos());
 		proc.push(++p);
 		break;
 
 	case OpCode::MUL:
-		switch(current.mod)
+		//packed 16-bit fields would otherwise be multiplied as int
+		switch(decoded.mod)
 		{
 		case Modifier::A:
-			pd->aVal = (dst.aVal * src.aVal) % core_.size_;
+			pd->aVal = core_.normalize(static_cast<unsigned int>(dst.aVal) * src.aVal);
 			break;
 
 		case Modifier::B:
-			pd->bVal = (dst.bVal * src.bVal) % core_.size_;
+			pd->bVal = core_.normalize(static_cast<unsigned int>(dst.bVal) * src.bVal);
 			break;
 
 		case Modifier::AB:
-			pd->bVal = (dst.bVal * src.aVal) % core_.size_;
+			pd->bVal = core_.normalize(static_cast<unsigned int>(dst.bVal) * src.aVal);
 			break;
 
 		case Modifier::BA:
-			pd->aVal = (dst.aVal * src.bVal) % core_.size_;
+			pd->aVal = core_.normalize(static_cast<unsigned int>(dst.aVal) * src.bVal);
 			break;
 
 		case Modifier::X:
-			pd->aVal = (dst.aVal * src.bVal) % core_.size_;
-			pd->bVal = (dst.bVal * src.aVal) % core_.size_;
+			pd->aVal = core_.normalize(static_cast<unsigned int>(dst.aVal) * src.bVal);
+			pd->bVal = core_.normalize(static_cast<unsigned int>(dst.bVal) * src.aVal);
 			break;
 
 		case Modifier::F:
 		case Modifier::I:
-			pd->aVal = (dst.aVal * src.aVal) % core_.size_;
-			pd->bVal = (dst.bVal * src.bVal) % core_.size_;
+			pd->aVal = core_.normalize(static_cast<unsigned int>(dst.aVal) * src.aVal);
+			pd->bVal = core_.normalize(static_cast<unsigned int>(dst.bVal) * src.bVal);
 			break;
 		}
+		written<Decoded::cached>(pd.pos());
 		report.read(ps.pos());
 		report.write(pd.pos());
 		proc.push(++p);
@@ -277,7 +491,7 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 	{
 		report.read(ps.pos());
 		bool divZero = false;
-		switch(current.mod)
+		switch(decoded.mod)
 		{
 		case Modifier::A:
 			if(!src.aVal)
@@ -325,7 +539,12 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 			if(src.aVal)
 				pd->bVal = dst.bVal / src.aVal;
 			if(!src.bVal || !src.aVal)
+			{
 				divZero = true;
+				//the field with a non-zero divisor was still written
+				if(src.bVal || src.aVal)
+					written<Decoded::cached>(pd.pos());
+			}
 			else
 				report.write(pd.pos());
 			break;
@@ -337,15 +556,26 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 			if(src.bVal)
 				pd->bVal = dst.bVal / src.bVal;
 			if(!src.aVal || !src.bVal)
+			{
 				divZero = true;
+				//the field with a non-zero divisor was still written
+				if(src.aVal || src.bVal)
+					written<Decoded::cached>(pd.pos());
+			}
 			else
 				report.write(pd.pos());
 			break;
 		}
 		if(!divZero)
+		{
+			written<Decoded::cached>(pd.pos());
 			proc.push(++p);
+		}
 		else
+		{
+			report.divideByZero();
 			report.killProcess();
+		}
 		break;
 	}//case OpCode::DIV
 
@@ -353,7 +583,7 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 	{
 		report.read(ps.pos());
 		bool divZero = false;
-		switch(current.mod)
+		switch(decoded.mod)
 		{
 		case Modifier::A:
 			if(!src.aVal)
@@ -401,7 +631,12 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 			if(src.aVal)
 				pd->bVal = dst.bVal % src.aVal;
 			if(!src.bVal || !src.aVal)
+			{
 				divZero = true;
+				//the field with a non-zero divisor was still written
+				if(src.bVal || src.aVal)
+					written<Decoded::cached>(pd.pos());
+			}
 			else
 				report.write(pd.pos());
 			break;
@@ -413,15 +648,26 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 			if(src.bVal)
 				pd->bVal = dst.bVal % src.bVal;
 			if(!src.aVal || !src.bVal)
+			{
 				divZero = true;
+				//the field with a non-zero divisor was still written
+				if(src.aVal || src.bVal)
+					written<Decoded::cached>(pd.pos());
+			}
 			else
 				report.write(pd.pos());
 			break;
 		}
 		if(!divZero)
+		{
+			written<Decoded::cached>(pd.pos());
 			proc.push(++p);
+		}
 		else
+		{
+			report.divideByZero();
 			report.killProcess();
+		}
 		break;
 	}
 
@@ -430,7 +676,7 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 		break;
 
 	case OpCode::JMZ:
-		switch(current.mod)
+		switch(decoded.mod)
 		{
 		case Modifier::A:
 		case Modifier::BA:
@@ -461,7 +707,7 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 		break;
 
 	case OpCode::JMN:
-		switch(current.mod)
+		switch(decoded.mod)
 		{
 		case Modifier::A:
 		case Modifier::BA:
@@ -492,7 +738,7 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 		break;
 
 	case OpCode::BEQ:
-		switch(current.mod)
+		switch(decoded.mod)
 		{
 		case Modifier::A:
 			if(dst.aVal == src.aVal)
@@ -550,7 +796,7 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 		break;
 
 	case OpCode::BNE:
-		switch(current.mod)
+		switch(decoded.mod)
 		{
 		case Modifier::A:
 			if(dst.aVal != src.aVal)
@@ -608,7 +854,7 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 		break;
 
 	case OpCode::BLT:
-		switch(current.mod)
+		switch(decoded.mod)
 		{
 		case Modifier::A:
 			if(dst.aVal > src.aVal)
@@ -661,13 +907,10 @@ void VirtualMachine::executeInstruction(ProcessQueue& proc, StatReport& report)
 	}//switch
 }
 
-void VirtualMachine::loadProgram(const std::vector<Instruction>& v, unsigned int offset, bool isP1)
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::startProcess(unsigned int offset, bool isP1) -> ProgramPtr
 {
-	//TODO EXCEPTION
-	if(v.size() > core_.size_)
-		throw std::invalid_argument("Too many instructions in loaded program");
-
-	ProgramPtr p = core_.begin() + offset;
+	ProgramPtr p = core_.at(core_.normalize(offset));
 
 	if(isP1)
 	{
@@ -687,61 +930,98 @@ void VirtualMachine::loadProgram(const std::vector<Instruction>& v, unsigned int
 		loaded_p2_ = true;
 	}
 
-	//load instructions into core
-	for(const auto& ins : v)
-		*(p++) = ins;
+	return p;
 }
 
-void VirtualMachine::loadProgram(const char* fname, unsigned int offset, bool isP1)
+template<class Rules, class Report>
+void BasicVirtualMachine<Rules, Report>::loadProgram(const std::vector<Instruction>& v, unsigned int offset, bool isP1)
 {
-	std::ifstream fin(fname, std::ifstream::in |
-					  std::ifstream::binary);
-
-	Instruction ins;
+	//TODO EXCEPTION
+	if(v.size() > core_.getSize())
+		throw std::invalid_argument("Too many instructions in loaded program");
 
-	ProgramPtr p = core_.begin() + offset;
+	ProgramPtr p = startProcess(offset, isP1);
 
-	if(isP1)
+	//load instructions into core, fields reduced modulo core size
+	for(const auto& ins : v)
 	{
-		if(loaded_p1_)
-			throw std::runtime_error("Player 1 has already been loaded");
+		written<true>(p.pos());
 
-		p1_.push(p);
-		loaded_p1_ = true;
+		*p = ins;
+		p->aVal = core_.normalize(ins.aVal);
+		p->bVal = core_.normalize(ins.bVal);
+
+		++p;
 	}
+}
 
-	else
+template<class Rules, class Report>
+void BasicVirtualMachine<Rules, Report>::loadProgram(const char* fname, unsigned int offset, bool isP1)
+{
+	loadProgram(ObjectFile(fname), offset, isP1);
+}
+
+template<class Rules, class Report>
+void BasicVirtualMachine<Rules, Report>::loadProgram(const ObjectFile& obj, unsigned int offset, bool isP1)
+{
+	//negative fields are stored relative to the header's core size
+	if(obj.getCoreSize() != core_.getSize())
+		throw std::invalid_argument("Object file was assembled for a different core size");
+
+	loadProgram(obj.data(), obj.size(), offset, isP1);
+}
+
+template<class Rules, class Report>
+void BasicVirtualMachine<Rules, Report>::loadProgram(const PackedInstruction* v, unsigned int count, unsigned int offset, bool isP1)
+{
+	if(count > core_.getSize())
+		throw std::invalid_argument("Too many instructions in loaded program");
+
+	ProgramPtr p = startProcess(offset, isP1);
+
+	unsigned int size = core_.getSize();
+
+	if constexpr(Rules::packed)
 	{
-		if(loaded_p2_)
-			throw std::runtime_error("Player 2 has already been loaded");
+		bool normalized = true;
 
-		p2_.push(p);
-		loaded_p2_ = true;
+		for(unsigned int i = 0; i < count && normalized; ++i)
+			normalized = v[i].aVal < size && v[i].bVal < size;
+
+		if(normalized)
+		{
+			//the program may wrap around the end of the core
+			unsigned int first = std::min(count, size - p.pos());
+
+			std::memcpy(&core_.memory_[p.pos()], v, first * sizeof(Cell));
+			std::memcpy(&core_.memory_[0], v + first, (count - first) * sizeof(Cell));
+
+			std::fill_n(decoded_.begin() + p.pos(), first, DecodedCell());
+			std::fill_n(decoded_.begin(), count - first, DecodedCell());
+
+			for(unsigned int i = 0; i < count; ++i)
+				dirty_[core_.wrap(p.pos() + i) / PageCells] = 1;
+
+			return;
+		}
 	}
 
-	do
+	for(unsigned int i = 0; i < count; ++i)
 	{
-		fin.read(reinterpret_cast<char*>(&ins.op), sizeof(OpCode));
-		fin.read(reinterpret_cast<char*>(&ins.mod), sizeof(Modifier));
-		fin.read(reinterpret_cast<char*>(&ins.aMode), sizeof(AddressMode));
-		fin.read(reinterpret_cast<char*>(&ins.bMode), sizeof(AddressMode));
-		fin.read(reinterpret_cast<char*>(&ins.aVal), sizeof(unsigned int));
-		fin.read(reinterpret_cast<char*>(&ins.bVal), sizeof(unsigned int));
-
-		if(fin.fail())
-			break;
+		written<true>(p.pos());
 
-		else
-			*p = ins;
+		*p = v[i];
+		p->aVal = core_.normalize(v[i].aVal);
+		p->bVal = core_.normalize(v[i].bVal);
 
 		++p;
-
-	}while(!fin.eof());
+	}
 }
 
-void VirtualMachine::executeCycle()
+template<class Rules, class Report>
+void BasicVirtualMachine<Rules, Report>::executeCycle()
 {
-	if(currentCycle_ >= maxCycles_)
+	if(state_ != ONGOING)
 		return;
 
 	++currentCycle_;
@@ -753,7 +1033,7 @@ void VirtualMachine::executeCycle()
 
 	if(p1_.empty())
 	{
-		StatReport::setState(StatReport::P2_WON);
+		state_ = P2_WON;
 
 		return;
 	}
@@ -762,135 +1042,285 @@ void VirtualMachine::executeCycle()
 
 	if(p2_.empty())
 	{
-		StatReport::setState(StatReport::P1_WON);
+		state_ = P1_WON;
 
 		return;
 	}
 
-	if(currentCycle_ >= maxCycles_)
-		StatReport::setState(StatReport::DRAW);
+	if(currentCycle_ >= getMaxCycles())
+		state_ = DRAW;
 }
 
-void VirtualMachine::reset()
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::runCycles(unsigned int n) -> MatchResult
 {
-	core_ = Core(core_.getSize());
+	if(!loaded_p1_ || !loaded_p2_)
+		throw std::runtime_error("Both players have to be loaded before running");
+
+	p1Report_.clear();
+	p2Report_.clear();
+
+	if(state_ != ONGOING)
+		return getResult();
+
+	unsigned int last = currentCycle_ + std::min(n, getMaxCycles() - currentCycle_);
+
+	while(currentCycle_ < last)
+	{
+		++currentCycle_;
+
+		executeInstruction(p1_, p1Report_);
+
+		if(p1_.empty())
+			break;
+
+		executeInstruction(p2_, p2Report_);
+
+		if(p2_.empty())
+			break;
+	}
+
+	if(p1_.empty())
+		state_ = P2_WON;
+
+	else if(p2_.empty())
+		state_ = P1_WON;
+
+	else if(currentCycle_ >= getMaxCycles())
+		state_ = DRAW;
+
+	return getResult();
+}
+
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::runToCompletion() -> MatchResult
+{
+	return runCycles(getMaxCycles());
+}
+
+template<class Rules, class Report>
+void BasicVirtualMachine<Rules, Report>::reset()
+{
+	core_.clear();
+
+	std::fill(decoded_.begin(), decoded_.end(), DecodedCell());
+	std::fill(dirty_.begin(), dirty_.end(), 1);
 
 	currentCycle_ = 0;
 
+	state_ = ONGOING;
+
 	loaded_p1_ = false;
 	loaded_p2_ = false;
 
-	while(!p1_.empty())
-		p1_.pop();
-
-	while(!p2_.empty())
-		p2_.pop();
+	p1_.clear();
+	p2_.clear();
 }
 
-unsigned int VirtualMachine::getCoreSize() const
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::snapshot() -> Snapshot
 {
-	return core_.size_;
+	unsigned int size = core_.getSize();
+
+	//clean pages are still shared with the previous snapshot
+	for(unsigned int i = 0; i < pages_.size(); ++i)
+	{
+		if(!dirty_[i])
+			continue;
+
+		unsigned int first = i * PageCells;
+		unsigned int count = std::min(PageCells, size - first);
+
+		std::shared_ptr<Page> page = std::make_shared<Page>();
+
+		std::copy_n(core_.memory_.begin() + first, count, page->begin());
+
+		pages_[i] = std::move(page);
+		dirty_[i] = 0;
+	}
+
+	return Snapshot(*this);
 }
 
-bool VirtualMachine::isLoadedP1() const
+template<class Rules, class Report>
+void BasicVirtualMachine<Rules, Report>::restore(const Snapshot& s)
 {
-	return loaded_p1_;
+	unsigned int size = core_.getSize();
+
+	if(s.coreSize_ != size)
+		throw std::invalid_argument("Snapshot was taken of a different core size");
+
+	for(unsigned int i = 0; i < pages_.size(); ++i)
+	{
+		if(!dirty_[i] && pages_[i] == s.pages_[i])
+			continue;
+
+		unsigned int first = i * PageCells;
+		unsigned int count = std::min(PageCells, size - first);
+
+		std::copy_n(s.pages_[i]->begin(), count, core_.memory_.begin() + first);
+		std::fill_n(decoded_.begin() + first, count, DecodedCell());
+
+		pages_[i] = s.pages_[i];
+		dirty_[i] = 0;
+	}
+
+	p1_ = s.p1_;
+	p2_ = s.p2_;
+
+	p1Report_ = s.p1Report_;
+	p2Report_ = s.p2Report_;
+
+	currentCycle_ = s.currentCycle_;
+
+	state_ = s.state_;
+
+	loaded_p1_ = s.loaded_p1_;
+	loaded_p2_ = s.loaded_p2_;
 }
 
-bool VirtualMachine::isLoadedP2() const
+template<class Rules, class Report>
+void BasicVirtualMachine<Rules, Report>::setEngine(Engine engine)
 {
-	return loaded_p2_;
+	//SWITCH does not keep the decode cache up to date
+	if(engine != engine_)
+		std::fill(decoded_.begin(), decoded_.end(), DecodedCell());
+
+	engine_ = engine;
 }
 
-VirtualMachine::StatReport& VirtualMachine::getP1Report()
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::getEngine() const -> Engine
 {
-	return p1Report_;
+	return engine_;
 }
 
-VirtualMachine::StatReport& VirtualMachine::getP2Report()
+template<class Rules, class Report>
+unsigned int BasicVirtualMachine<Rules, Report>::getCoreSize() const
 {
-	return p2Report_;
+	return core_.getSize();
 }
 
-Core::Core(unsigned int s) : size_(s)
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::getInstruction(unsigned int adr) const -> Instruction
 {
-	if(!size_)
-		throw std::invalid_argument("Core size cannot be zero");
+	return core_.memory_[adr];
+}
 
-	memory_ = std::vector<Instruction>(size_, Instruction());
+template<class Rules, class Report>
+unsigned int BasicVirtualMachine<Rules, Report>::getMaxProcesses() const
+{
+	return Rules::maxProcesses ? Rules::maxProcesses : maxProcesses_;
 }
 
-ProgramPtr Core::begin()
+template<class Rules, class Report>
+unsigned int BasicVirtualMachine<Rules, Report>::getMaxCycles() const
 {
-	return ProgramPtr(memory_.begin(), *this);
+	return Rules::maxCycles ? Rules::maxCycles : maxCycles_;
 }
 
-unsigned int Core::getSize() const
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::getState() const -> RoundState
 {
-	return size_;
+	return state_;
 }
 
-ProgramPtr& ProgramPtr::operator=(const ProgramPtr& other)
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::getResult() const -> MatchResult
 {
-	it_ = other.it_;
-	ref_ = other.ref_;
+	MatchResult res;
 
-	return *this;
+	res.state = state_;
+	res.cycles = currentCycle_;
+	res.p1Processes = p1_.size();
+	res.p2Processes = p2_.size();
+
+	return res;
 }
 
-Instruction& ProgramPtr::operator*()
+template<class Rules, class Report>
+bool BasicVirtualMachine<Rules, Report>::isLoadedP1() const
 {
-	return *it_;
+	return loaded_p1_;
 }
 
-Instruction* ProgramPtr::operator->()
+template<class Rules, class Report>
+bool BasicVirtualMachine<Rules, Report>::isLoadedP2() const
 {
-	return it_.operator->();
+	return loaded_p2_;
 }
 
-ProgramPtr ProgramPtr::operator+(unsigned int n)
+template<class Rules, class Report>
+unsigned int BasicVirtualMachine<Rules, Report>::getPeakProcessesP1() const
 {
-	ProgramPtr result = *this;
-
-	result += n;
+	return p1_.peak();
+}
 
-	return result;
+template<class Rules, class Report>
+unsigned int BasicVirtualMachine<Rules, Report>::getPeakProcessesP2() const
+{
+	return p2_.peak();
 }
 
-ProgramPtr& ProgramPtr::operator+=(unsigned int n)
+template<class Rules, class Report>
+Report& BasicVirtualMachine<Rules, Report>::getP1Report()
 {
-	std::ptrdiff_t d = it_ - ref_.memory_.begin();
+	return p1Report_;
+}
 
-	d = (d + n) % ref_.size_;
+template<class Rules, class Report>
+Report& BasicVirtualMachine<Rules, Report>::getP2Report()
+{
+	return p2Report_;
+}
 
-	it_ = ref_.memory_.begin() + d;
+template<class Rules, class Report>
+BasicVirtualMachine<Rules, Report>::Snapshot::Snapshot(const BasicVirtualMachine& vm)
+	: pages_(vm.pages_),
+	  p1_(vm.p1_),
+	  p2_(vm.p2_),
+	  p1Report_(vm.p1Report_),
+	  p2Report_(vm.p2Report_),
+	  coreSize_(vm.core_.getSize()),
+	  currentCycle_(vm.currentCycle_),
+	  state_(vm.state_),
+	  loaded_p1_(vm.loaded_p1_),
+	  loaded_p2_(vm.loaded_p2_)
+{
 
-	return *this;
 }
 
-ProgramPtr& ProgramPtr::operator++()
+template<class Rules, class Report>
+unsigned int BasicVirtualMachine<Rules, Report>::Snapshot::getCycle() const
 {
-	if(it_ == ref_.memory_.end() - 1)
-		it_ = ref_.memory_.begin();
-
-	else
-		++it_;
+	return currentCycle_;
+}
 
-	return *this;
+template<class Rules, class Report>
+auto BasicVirtualMachine<Rules, Report>::Snapshot::getState() const -> RoundState
+{
+	return state_;
 }
 
-ProgramPtr ProgramPtr::operator++(int)
+template<class Rules, class Report>
+BasicVirtualMachine<Rules, Report>::Core::Core(unsigned int s) : size_(s), mask_(0)
 {
-	ProgramPtr ret = *this;
+	if(!size_)
+		throw std::invalid_argument("Core size cannot be zero");
+
+	if(Rules::coreSize && size_ != Rules::coreSize)
+		throw std::invalid_argument("Core size does not match the rule set");
 
-	++(*this);
+	if(!(size_ & (size_ - 1)))
+		mask_ = size_ - 1;
 
-	return ret;
+	initStorage(memory_, size_, Cell());
 }
 
-unsigned int ProgramPtr::pos() const
+template<class Rules, class Report>
+void BasicVirtualMachine<Rules, Report>::Core::clear()
 {
-	return it_ - ref_.memory_.begin();
+	std::fill(memory_.begin(), memory_.end(), Cell());
 }
 
 bool Instruction::operator==(const Instruction& other) const
@@ -898,8 +1328,8 @@ bool Instruction::operator==(const Instruction& other) const
 	return op == other.op &&
 			mod == other.mod &&
 			aMode == other.aMode &&
-			aVal == other.aVal &&
 			bMode == other.bMode &&
+			aVal == other.aVal &&
 			bVal == other.bVal;
 }
 
@@ -908,7 +1338,12 @@ bool Instruction::operator!=(const Instruction& other) const
 	return !operator==(other);
 }
 
-StatReport::StatReport() : procCount_(1)
+StatReport::StatReport()
+
+	: heat_(8000),
+	  writeAdr_(0), executedAdr_(0),
+	  executed_(false), written_(false),
+	  procCount_(1)
 {
 
 }
@@ -916,17 +1351,23 @@ StatReport::StatReport() : procCount_(1)
 void StatReport::exec(unsigned int adr, const Instruction & ins)
 {
 	executedAdr_ = adr;
+	executed_ = true;
 	ins_ = ins;
+
+	heat_.add(Heatmap::EXEC, adr);
 }
 
 void StatReport::read(unsigned int adr)
 {
-	readAdrs_.push_back(adr);
+	heat_.add(Heatmap::READ, adr);
 }
 
 void StatReport::write(unsigned int adr)
 {
 	writeAdr_ = adr;
+	written_ = true;
+
+	heat_.add(Heatmap::WRITE, adr);
 }
 
 void StatReport::createProcess()
@@ -939,24 +1380,33 @@ void StatReport::killProcess()
 	--procCount_;
 }
 
-void StatReport::setState(StatReport::RoundState rs)
+void StatReport::clear()
 {
-	state_ = rs;
+	executed_ = false;
+	written_ = false;
 }
 
-void StatReport::clear()
+void StatReport::reset()
 {
-	readAdrs_.clear();
+	heat_.reset();
+}
 
-	state_ = ONGOING;
+void StatReport::setCoreSize(unsigned int size)
+{
+	heat_.resize(size);
 }
 
 std::string StatReport::toString()
 {
-	return op[ins_.op] + "." +
-			mod[ins_.mod] + "\t" +
-			address[ins_.aMode] + std::to_string(ins_.aVal) + "\t" +
-			address[ins_.bMode] + std::to_string(ins_.bVal);
+	return toString(ins_);
+}
+
+std::string StatReport::toString(const Instruction& ins)
+{
+	return op[ins.op] + "." +
+			mod[ins.mod] + "\t" +
+			address[ins.aMode] + std::to_string(ins.aVal) + "\t" +
+			address[ins.bMode] + std::to_string(ins.bVal);
 }
 
 unsigned int StatReport::getProcessCount() const
@@ -969,12 +1419,179 @@ unsigned int StatReport::getExecutedAdr() const
 	return executedAdr_;
 }
 
+auto StatReport::getInstruction() const -> const Instruction&
+{
+	return ins_;
+}
+
 unsigned int StatReport::getWriteAdr() const
 {
 	return writeAdr_;
 }
 
-StatReport::RoundState StatReport::getState()
+bool StatReport::hasExecuted() const
 {
-	return state_;
+	return executed_;
 }
+
+bool StatReport::hasWritten() const
+{
+	return written_;
+}
+
+const Heatmap& StatReport::getHeatmap() const
+{
+	return heat_;
+}
+
+HeatmapReport::HeatmapReport(unsigned int size) : heat_(size)
+{
+
+}
+
+void HeatmapReport::reset()
+{
+	heat_.reset();
+}
+
+void HeatmapReport::setCoreSize(unsigned int size)
+{
+	heat_.resize(size);
+}
+
+const Heatmap& HeatmapReport::getHeatmap() const
+{
+	return heat_;
+}
+
+ProfileReport::ProfileReport()
+{
+	reset();
+}
+
+void ProfileReport::phase(Phase next)
+{
+	Clock::time_point now = Clock::now();
+
+	if(phase_ != IDLE)
+		phaseTime_[phase_] += now - phaseStart_;
+
+	phase_ = next;
+	phaseStart_ = now;
+}
+
+void ProfileReport::reset()
+{
+	executions_.fill(0);
+
+	spawns_ = 0;
+	kills_ = 0;
+	divisionKills_ = 0;
+
+	phaseTime_.fill(Clock::duration::zero());
+
+	phase_ = IDLE;
+}
+
+ProfileReport& ProfileReport::operator+=(const ProfileReport& other)
+{
+	for(unsigned int i = 0; i < executions_.size(); ++i)
+		executions_[i] += other.executions_[i];
+
+	spawns_ += other.spawns_;
+	kills_ += other.kills_;
+	divisionKills_ += other.divisionKills_;
+
+	for(unsigned int i = 0; i < phaseTime_.size(); ++i)
+		phaseTime_[i] += other.phaseTime_[i];
+
+	return *this;
+}
+
+unsigned long long ProfileReport::getExecutions() const
+{
+	unsigned long long total = 0;
+
+	for(auto n : executions_)
+		total += n;
+
+	return total;
+}
+
+unsigned long long ProfileReport::getExecutions(OpCode op, Modifier mod, AddressMode aMode, AddressMode bMode) const
+{
+	return executions_[index(op, mod, aMode, bMode)];
+}
+
+unsigned long long ProfileReport::getSpawns() const
+{
+	return spawns_;
+}
+
+unsigned long long ProfileReport::getKills() const
+{
+	return kills_;
+}
+
+unsigned long long ProfileReport::getDivisionKills() const
+{
+	return divisionKills_;
+}
+
+auto ProfileReport::getPhaseTime(Phase phase) const -> Clock::duration
+{
+	return phase < IDLE ? phaseTime_[phase] : Clock::duration::zero();
+}
+
+std::string ProfileReport::toString() const
+{
+	std::vector<unsigned int> used;
+
+	for(unsigned int i = 0; i < executions_.size(); ++i)
+		if(executions_[i])
+			used.push_back(i);
+
+	std::stable_sort(used.begin(), used.end(), [this](unsigned int a, unsigned int b)
+	{
+		return executions_[a] > executions_[b];
+	});
+
+	std::string out;
+
+	for(auto i : used)
+	{
+		unsigned int bMode = i % AddressModes;
+		unsigned int aMode = i / AddressModes % AddressModes;
+		unsigned int mod = i / (AddressModes * AddressModes) % Modifiers;
+		unsigned int op = i / (AddressModes * AddressModes * Modifiers);
+
+		out += StatReport::op[op] + "." + StatReport::mod[mod] + "\t" +
+				StatReport::address[aMode] + "\t" + StatReport::address[bMode] + "\t" +
+				std::to_string(executions_[i]) + "\n";
+	}
+
+	static const char* phases[] = {"fetch", "operands", "execute"};
+
+	out += "executed\t" + std::to_string(getExecutions()) + "\n" +
+			"spawned\t" + std::to_string(spawns_) + "\n" +
+			"killed\t" + std::to_string(kills_) + "\n" +
+			"divided_by_zero\t" + std::to_string(divisionKills_) + "\n";
+
+	for(unsigned int i = 0; i < phaseTime_.size(); ++i)
+		out += std::string(phases[i]) + "_ns\t" +
+				std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(phaseTime_[i]).count()) + "\n";
+
+	return out;
+}
+
+template class BasicVirtualMachine<RuntimeRules>;
+template class BasicVirtualMachine<StandardRules>;
+template class BasicVirtualMachine<PackedStandardRules>;
+
+template class BasicVirtualMachine<RuntimeRules, VirtualMachineBase::NullReport>;
+template class BasicVirtualMachine<StandardRules, VirtualMachineBase::NullReport>;
+template class BasicVirtualMachine<PackedStandardRules, VirtualMachineBase::NullReport>;
+
+template class BasicVirtualMachine<PackedStandardRules, VirtualMachineBase::HeatmapReport>;
+
+template class BasicVirtualMachine<PackedStandardRules, VirtualMachineBase::ProfileReport>;
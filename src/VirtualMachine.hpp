@@ -2,36 +2,70 @@
 #define VIRTUALMACHINE_HPP
 
 #include <vector>
-#include <queue>
+#include <array>
 #include <string>
-
-class VirtualMachine
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <memory>
+
+#include "Heatmap.hpp"
+
+class ObjectFile;
+
+/*!
+ * \brief Limits a BasicVirtualMachine is specialized on
+ *
+ * A non-zero parameter becomes a compile-time constant: offsets wrap with
+ * a constant modulus and the core, decode cache and process queues are
+ * held in fixed-size arrays. A zero parameter is left to run time; the
+ * core size is then taken from the constructor and the process and cycle
+ * limits default to 64 and 20000.
+ *
+ * Packed cores store each cell as a single 64-bit word with 16-bit
+ * fields and require a fixed core size of at most 65536.
+ */
+template<unsigned int CoreSize, unsigned int MaxProcesses, unsigned int MaxCycles,
+		 bool Packed = false>
+struct RuleSet
 {
-public:
+	static constexpr unsigned int coreSize = CoreSize;
+	static constexpr unsigned int maxProcesses = MaxProcesses;
+	static constexpr unsigned int maxCycles = MaxCycles;
 
-	class Core
-	{
-	public:
+	static constexpr bool packed = Packed;
+};
 
-		class ProgramPtr;
-		struct Instruction;
+template<unsigned int CoreSize, unsigned int MaxProcesses, unsigned int MaxCycles, bool Packed>
+constexpr unsigned int RuleSet<CoreSize, MaxProcesses, MaxCycles, Packed>::coreSize;
 
-		Core(unsigned int);
+template<unsigned int CoreSize, unsigned int MaxProcesses, unsigned int MaxCycles, bool Packed>
+constexpr unsigned int RuleSet<CoreSize, MaxProcesses, MaxCycles, Packed>::maxProcesses;
 
-		ProgramPtr begin();
+template<unsigned int CoreSize, unsigned int MaxProcesses, unsigned int MaxCycles, bool Packed>
+constexpr unsigned int RuleSet<CoreSize, MaxProcesses, MaxCycles, Packed>::maxCycles;
 
-		unsigned int getSize() const;
+template<unsigned int CoreSize, unsigned int MaxProcesses, unsigned int MaxCycles, bool Packed>
+constexpr bool RuleSet<CoreSize, MaxProcesses, MaxCycles, Packed>::packed;
 
-	private:
+//every limit chosen at run time
+using RuntimeRules = RuleSet<0, 0, 0>;
 
-		std::vector<Instruction> memory_;
+//8000 cells, 64 processes per player, 20000 cycles
+using StandardRules = RuleSet<8000, 64, 20000>;
 
-		unsigned int size_;
+//StandardRules with 8-byte core cells
+using PackedStandardRules = RuleSet<8000, 64, 20000, true>;
 
-		friend class VirtualMachine;
-	};//Core
+/*!
+ * \brief Types shared by every BasicVirtualMachine specialization
+ */
+class VirtualMachineBase
+{
+public:
 
-	struct Core::Instruction
+	struct Instruction
 	{
 		enum OpCode : unsigned char {KIL, FRK, NOP, MOV, ADD, SUB, MUL, DIV, MOD,
 									 JMP, JMZ, JMN, BEQ, BNE, BLT};
@@ -43,32 +77,84 @@ public:
 					AddressMode am = DIR, AddressMode bm = DIR)
 
 			: op(o), mod(m),
-			  aMode(am), aVal(a),
-			  bMode(bm), bVal(b) {}
+			  aMode(am), bMode(bm),
+			  aVal(a), bVal(b) {}
 
 		OpCode op;
 
 		Modifier mod;
 
 		AddressMode aMode;
-		unsigned int aVal;
-
 		AddressMode bMode;
+
+		unsigned int aVal;
 		unsigned int bVal;
 
 		bool operator==(const Instruction&) const;
 		bool operator!=(const Instruction&) const;
 	};//Instruction
 
+	/*!
+	 * \brief Core cell holding an Instruction in a single 64-bit word
+	 *
+	 * Field values must be below 65536. Copies and comparisons
+	 * operate on the whole word.
+	 */
+	struct PackedInstruction
+	{
+		PackedInstruction(const Instruction& ins = Instruction())
+
+			: op(ins.op), mod(ins.mod),
+			  aMode(ins.aMode), bMode(ins.bMode),
+			  aVal(static_cast<std::uint16_t>(ins.aVal)),
+			  bVal(static_cast<std::uint16_t>(ins.bVal)) {}
+
+		operator Instruction() const;
+
+		Instruction::OpCode op;
+
+		Instruction::Modifier mod;
+
+		Instruction::AddressMode aMode;
+		Instruction::AddressMode bMode;
+
+		std::uint16_t aVal;
+		std::uint16_t bVal;
+
+		bool operator==(const PackedInstruction&) const;
+		bool operator!=(const PackedInstruction&) const;
+	};//PackedInstruction
+
+	/*!
+	 * \brief Stage of an instruction, as passed to the phase() report hook
+	 *
+	 * FETCH covers the process queue and the decode cache, OPERANDS the
+	 * evaluation of the A and B addresses, EXECUTE the opcode itself.
+	 * IDLE is entered once the instruction has retired.
+	 */
+	enum Phase {FETCH, OPERANDS, EXECUTE, IDLE};
+
+	class ProfileReport;
+
+	/*!
+	 * \brief Report of the last executed instruction, for display
+	 *
+	 * Also counts the executions, reads and writes of every cell in a
+	 * Heatmap sized to the core by the BasicVirtualMachine. The counts
+	 * survive the per-cycle clear() and only reset() drops them.
+	 * The addresses are only meaningful while hasExecuted() or
+	 * hasWritten() tells they were set since the last clear().
+	 */
 	class StatReport
 	{
 	public:
 
-		enum RoundState {ONGOING, DRAW, P1_WON, P2_WON};
-
+		/*!
+		 * \brief Sized for the default core, until setCoreSize() is called
+		 */
 		StatReport();
 
-		void exec(unsigned int, const VirtualMachine::Core::Instruction&);
+		void exec(unsigned int, const Instruction&);
 
 		void read(unsigned int);
 		void write(unsigned int);
@@ -76,97 +162,647 @@ public:
 		void createProcess();
 		void killProcess();
 
-		static void setState(RoundState);
+		void divideByZero() {}
+
+		void phase(Phase) {}
 
 		void clear();
 
+		void reset();
+
+		/*!
+		 * \brief Sizes the Heatmap, called by the BasicVirtualMachine owning the report
+		 */
+		void setCoreSize(unsigned int);
+
 		std::string toString();
 
+		/*!
+		 * \brief Text of an instruction, as shown by the player logs
+		 */
+		static std::string toString(const Instruction&);
+
 		unsigned int getProcessCount() const;
 
 		unsigned int getExecutedAdr() const;
 
+		const Instruction& getInstruction() const;
+
 		unsigned int getWriteAdr() const;
 
-		static RoundState getState();
+		/*!
+		 * \brief True if the player executed an instruction since the last clear()
+		 */
+		bool hasExecuted() const;
+
+		/*!
+		 * \brief True if the player wrote a cell since the last clear()
+		 */
+		bool hasWritten() const;
+
+		const Heatmap& getHeatmap() const;
 
 	private:
 
-		std::vector<unsigned int> readAdrs_;
+		Heatmap heat_;
+
 		unsigned int writeAdr_;
 
 		unsigned int executedAdr_;
 
-		unsigned int procCount_;
+		bool executed_;
+		bool written_;
 
-		VirtualMachine::Core::Instruction ins_;
+		unsigned int procCount_;
 
-		static RoundState state_;
+		Instruction ins_;
 
-		static std::string op[10];
+		static std::string op[15];
 		static std::string mod[7];
 		static std::string address[4];
+
+		friend class ProfileReport;
 	};//StatReport
 
+	/*!
+	 * \brief Report that records nothing
+	 *
+	 * Every hook is an empty inline function, so a BasicVirtualMachine
+	 * using it does no per-instruction bookkeeping.
+	 */
+	class NullReport
+	{
+	public:
+
+		template<class Cell>
+		void exec(unsigned int, const Cell&) {}
+
+		void read(unsigned int) {}
+		void write(unsigned int) {}
+
+		void createProcess() {}
+		void killProcess() {}
+
+		void divideByZero() {}
+
+		void phase(Phase) {}
+
+		void clear() {}
+	};//NullReport
+
+	/*!
+	 * \brief Report that only counts the accesses to every cell
+	 *
+	 * Keeps the Heatmap of a StatReport without copying the executed
+	 * Instruction every cycle, for machines that run at full speed and
+	 * are only inspected once the match is over.
+	 */
+	class HeatmapReport
+	{
+	public:
+
+		explicit HeatmapReport(unsigned int = 8000);
+
+		template<class Cell>
+		void exec(unsigned int adr, const Cell&)
+		{
+			heat_.add(Heatmap::EXEC, adr);
+		}
+
+		void read(unsigned int adr)
+		{
+			heat_.add(Heatmap::READ, adr);
+		}
+
+		void write(unsigned int adr)
+		{
+			heat_.add(Heatmap::WRITE, adr);
+		}
+
+		void createProcess() {}
+		void killProcess() {}
+
+		void divideByZero() {}
+
+		void phase(Phase) {}
+
+		void clear() {}
+
+		void reset();
+
+		/*!
+		 * \brief Sizes the Heatmap, called by the BasicVirtualMachine owning the report
+		 */
+		void setCoreSize(unsigned int);
+
+		const Heatmap& getHeatmap() const;
+
+	private:
+
+		Heatmap heat_;
+	};//HeatmapReport
+
+	/*!
+	 * \brief Report that counts which paths the executed instructions take
+	 *
+	 * Counts executions per opcode, modifier and pair of addressing modes,
+	 * FRK spawns, killed processes and DIV/MOD-by-zero kills, and
+	 * measures the time spent in every Phase. Counters survive the
+	 * per-cycle clear() and only reset() drops them, so a report covers
+	 * one match when reset before it or many when merged with +=.
+	 *
+	 * Timing reads the clock several times per instruction; the
+	 * other reports leave the hooks empty and pay nothing.
+	 */
+	class ProfileReport
+	{
+	public:
+
+		using Clock = std::chrono::steady_clock;
+
+		ProfileReport();
+
+		template<class Cell>
+		void exec(unsigned int, const Cell& ins)
+		{
+			++executions_[index(ins.op, ins.mod, ins.aMode, ins.bMode)];
+		}
+
+		void read(unsigned int) {}
+		void write(unsigned int) {}
+
+		void createProcess() {++spawns_;}
+		void killProcess() {++kills_;}
+
+		void divideByZero() {++divisionKills_;}
+
+		void phase(Phase);
+
+		void clear() {}
+
+		void reset();
+
+		ProfileReport& operator+=(const ProfileReport&);
+
+		unsigned long long getExecutions() const;
+
+		unsigned long long getExecutions(Instruction::OpCode, Instruction::Modifier,
+										 Instruction::AddressMode, Instruction::AddressMode) const;
+
+		unsigned long long getSpawns() const;
+
+		unsigned long long getKills() const;
+
+		unsigned long long getDivisionKills() const;
+
+		Clock::duration getPhaseTime(Phase) const;
+
+		/*!
+		 * \brief One line per executed tuple, most frequent first, followed by the totals
+		 */
+		std::string toString() const;
+
+	private:
+
+		static constexpr unsigned int OpCodes = Instruction::BLT + 1;
+		static constexpr unsigned int Modifiers = Instruction::I + 1;
+		static constexpr unsigned int AddressModes = Instruction::BIN + 1;
+
+		static unsigned int index(unsigned int op, unsigned int mod, unsigned int aMode, unsigned int bMode)
+		{
+			return ((op * Modifiers + mod) * AddressModes + aMode) * AddressModes + bMode;
+		}
+
+		std::array<unsigned long long, OpCodes * Modifiers * AddressModes * AddressModes> executions_;
+
+		unsigned long long spawns_;
+		unsigned long long kills_;
+		unsigned long long divisionKills_;
+
+		std::array<Clock::duration, IDLE> phaseTime_;
+
+		Phase phase_;
+		Clock::time_point phaseStart_;
+	};//ProfileReport
+
+	/*!
+	 * \brief Instruction execution strategy
+	 *
+	 * SWITCH decodes every instruction as it is executed.
+	 * PREDECODED caches a handler and the A/B target addresses
+	 * per core cell and decodes a cell again only after it is written.
+	 */
+	enum Engine {SWITCH, PREDECODED};
+
+	enum RoundState {ONGOING, DRAW, P1_WON, P2_WON};
+
+	/*!
+	 * \brief Outcome of a batch of cycles
+	 *
+	 * state is ONGOING when the batch ended before the round did.
+	 */
+	struct MatchResult
+	{
+		RoundState state;
+
+		unsigned int cycles;
+
+		unsigned int p1Processes;
+		unsigned int p2Processes;
+	};
+};
+
+/*!
+ * \brief MARS virtual machine specialized on a RuleSet
+ *
+ * Report receives the exec/read/write/process hooks of every executed
+ * instruction; StatReport records them for display, NullReport drops
+ * them at compile time, HeatmapReport counts the accessed cells and
+ * ProfileReport the executed paths.
+ *
+ * RuntimeRules, StandardRules and PackedStandardRules are instantiated
+ * with StatReport and NullReport, PackedStandardRules also with
+ * HeatmapReport and ProfileReport, in VirtualMachine.cpp.
+ *
+ * Instances share no mutable state, so separate instances may run
+ * concurrently, one thread per instance. Snapshots only share read-only
+ * core pages and may be restored into any machine of the same type and
+ * core size, on any thread. A fixed-size core is stored inline, so
+ * specializations other than RuntimeRules are best allocated
+ * on the heap when many of them are alive at once.
+ */
+template<class Rules, class Report = VirtualMachineBase::StatReport>
+class BasicVirtualMachine : public VirtualMachineBase
+{
+	static_assert(!Rules::packed || (Rules::coreSize && Rules::coreSize <= 65536),
+				  "Packed cores need a fixed core size of at most 65536");
+
+	//std::array when N is known at compile time, std::vector otherwise
+	template<class T, unsigned int N>
+	using Storage = typename std::conditional<N != 0, std::array<T, N>, std::vector<T>>::type;
+
+public:
+
+	class Core
+	{
+	public:
+
+		class ProgramPtr;
+		using Instruction = VirtualMachineBase::Instruction;
+
+		//layout of a single core cell
+		using Cell = typename std::conditional<Rules::packed, PackedInstruction, Instruction>::type;
+
+		Core(unsigned int);
+
+		ProgramPtr begin();
+
+		unsigned int getSize() const;
+
+		/*!
+		 * \brief Reduces an offset below 2 * size to the range [0, size)
+		 *
+		 * Uses a mask for power-of-two cores and a single conditional
+		 * subtraction otherwise.
+		 */
+		unsigned int wrap(unsigned int) const;
+
+		/*!
+		 * \brief Reduces any offset to the range [0, size)
+		 */
+		unsigned int normalize(unsigned int) const;
+
+	private:
+
+		ProgramPtr at(unsigned int);
+
+		void clear();
+
+		unsigned int mask() const;
+
+		static constexpr unsigned int fixedMask()
+		{
+			return Rules::coreSize && !(Rules::coreSize & (Rules::coreSize - 1)) ?
+						Rules::coreSize - 1 : 0;
+		}
+
+		Storage<Cell, Rules::coreSize> memory_;
+
+		unsigned int size_;
+
+		//size_ - 1 for power-of-two sizes, 0 otherwise
+		unsigned int mask_;
+
+		friend class BasicVirtualMachine;
+	};//Core
+
 private:
 
-	using ProcessQueue = std::queue<Core::ProgramPtr>;
+	using ProgramPtr = typename Core::ProgramPtr;
+	using Cell = typename Core::Cell;
+
+	/*!
+	 * \brief Fixed-capacity ring buffer of core offsets, one per live process
+	 *
+	 * Storage is allocated once, in the constructor; push() and pop()
+	 * never allocate. peak() reports the highest occupancy since
+	 * construction or the last clear().
+	 */
+	class ProcessQueue
+	{
+	public:
+
+		explicit ProcessQueue(unsigned int);
+
+		bool empty() const;
+
+		unsigned int size() const;
+
+		unsigned int capacity() const;
+
+		unsigned int peak() const;
+
+		unsigned int front() const;
+
+		void push(unsigned int);
+		void push(const ProgramPtr&);
+
+		void pop();
+
+		void clear();
+
+	private:
+
+		Storage<unsigned int, Rules::maxProcesses> slots_;
+
+		unsigned int head_;
+		unsigned int size_;
+		unsigned int peak_;
+	};
+
+	//unit of copy-on-write of the core, see Snapshot
+	static constexpr unsigned int PageCells = 64;
+
+	using Page = std::array<Cell, PageCells>;
+
+	//pages of a fixed-size core, 0 when the size is chosen at run time
+	static constexpr unsigned int FixedPages = (Rules::coreSize + PageCells - 1) / PageCells;
 
 public:
 
-	VirtualMachine(unsigned int = 8000);
+	/*!
+	 * \brief Whole state of a machine, taken by snapshot() and put back by restore()
+	 *
+	 * The core is held as pages of PageCells cells, shared read-only
+	 * between the machine and every snapshot taken from it: a snapshot
+	 * copies only the pages written since the previous one, and a restore
+	 * only the pages that differ from the machine's. Process queues,
+	 * reports, the cycle counter and the round state are copied whole.
+	 * The engine is a setting of the machine and is kept.
+	 */
+	class Snapshot
+	{
+	public:
+
+		unsigned int getCycle() const;
+
+		RoundState getState() const;
+
+	private:
+
+		explicit Snapshot(const BasicVirtualMachine&);
+
+		std::vector<std::shared_ptr<const Page>> pages_;
+
+		ProcessQueue p1_;
+		ProcessQueue p2_;
+
+		Report p1Report_;
+		Report p2Report_;
 
-	void loadProgram(const std::vector<Core::Instruction>&, unsigned int, bool = true);
+		unsigned int coreSize_;
+
+		unsigned int currentCycle_;
+
+		RoundState state_;
+
+		bool loaded_p1_;
+		bool loaded_p2_;
+
+		friend class BasicVirtualMachine;
+	};
+
+	BasicVirtualMachine(unsigned int = Rules::coreSize ? Rules::coreSize : 8000,
+						Engine = SWITCH);
+
+	void loadProgram(const std::vector<Instruction>&, unsigned int, bool = true);
+
+	/*!
+	 * \brief Loads an ObjectFile, throws std::runtime_error if it is invalid
+	 * and std::invalid_argument if it was assembled for another core size
+	 */
 	void loadProgram(const char*, unsigned int, bool = true);
 
+	/*!
+	 * \brief Loads the cells of an ObjectFile in place, throws std::invalid_argument
+	 * if it was assembled for another core size
+	 */
+	void loadProgram(const ObjectFile&, unsigned int, bool = true);
+
+	/*!
+	 * \brief Loads packed instructions, copied in bulk when the core stores packed cells
+	 * and every field is already below the core size
+	 */
+	void loadProgram(const PackedInstruction*, unsigned int, unsigned int, bool = true);
+
 	void executeCycle();
 
+	/*!
+	 * \brief Executes up to n cycles, stopping early when the round ends
+	 *
+	 * The reports are cleared once, before the batch, and then collect
+	 * every cycle in it; the round state is set once, after it.
+	 */
+	MatchResult runCycles(unsigned int);
+
+	/*!
+	 * \brief Executes cycles until a player dies or the cycle limit is hit
+	 */
+	MatchResult runToCompletion();
+
 	void reset();
 
+	Snapshot snapshot();
+
+	/*!
+	 * \brief Returns to a snapshot, throws std::invalid_argument if its core size differs
+	 */
+	void restore(const Snapshot&);
+
+	void setEngine(Engine);
+
+	Engine getEngine() const;
+
+	RoundState getState() const;
+
+	MatchResult getResult() const;
+
 	unsigned int getCoreSize() const;
 
+	/*!
+	 * \brief Cell at an address below the core size, unpacked
+	 */
+	Instruction getInstruction(unsigned int) const;
+
+	unsigned int getMaxProcesses() const;
+
+	unsigned int getMaxCycles() const;
+
 	bool isLoadedP1() const;
 	bool isLoadedP2() const;
 
-	StatReport& getP1Report();
-	StatReport& getP2Report();
+	unsigned int getPeakProcessesP1() const;
+	unsigned int getPeakProcessesP2() const;
+
+	Report& getP1Report();
+	Report& getP2Report();
 
 private:
 
-	void executeInstruction(ProcessQueue&, StatReport&);
+	using Handler = void (*)(BasicVirtualMachine&, ProcessQueue&, Report&, ProgramPtr);
+
+	//cached decoding of a core cell, dropped whenever the cell is written
+	struct DecodedCell
+	{
+		Handler handler = nullptr;
+
+		unsigned int aTarget = 0;
+		unsigned int bTarget = 0;
+	};
+
+	template<class T>
+	static void initStorage(std::vector<T>&, unsigned int, const T&);
+
+	template<class T, std::size_t N>
+	static void initStorage(std::array<T, N>&, unsigned int, const T&);
+
+	void executeInstruction(ProcessQueue&, Report&);
+
+	template<class Decoded>
+	void execute(const Decoded&, ProcessQueue&, Report&, ProgramPtr);
+
+	template<Instruction::OpCode O, Instruction::Modifier M>
+	static void executeDecoded(BasicVirtualMachine&, ProcessQueue&, Report&, ProgramPtr);
+
+	Handler decode(ProgramPtr);
+
+	static Handler selectHandler(const Cell&);
+
+	//registers the first process of a player
+	ProgramPtr startProcess(unsigned int, bool);
+
+	//a written cell has to be decoded again and copied by the next snapshot
+	template<bool Cached>
+	void written(unsigned int);
+
+	unsigned int maxCycles_;
+	unsigned int maxProcesses_;
 
 	ProcessQueue p1_;
 	ProcessQueue p2_;
 
-	StatReport p1Report_;
-	StatReport p2Report_;
+	Report p1Report_;
+	Report p2Report_;
 
 	Core core_;
 
-	unsigned int maxCycles_;
-	unsigned int maxProcesses_;
+	Storage<DecodedCell, Rules::coreSize> decoded_;
+
+	//pages the core matched at the last snapshot() or restore(), null before the first one
+	std::vector<std::shared_ptr<const Page>> pages_;
+
+	//1 for every page written since
+	Storage<unsigned char, FixedPages> dirty_;
+
+	Engine engine_;
 
 	unsigned int currentCycle_;
 
+	RoundState state_;
+
 	bool loaded_p1_;
 	bool loaded_p2_;
 };
 
+//core size chosen at run time
+using VirtualMachine = BasicVirtualMachine<RuntimeRules>;
+
+using StandardVirtualMachine = BasicVirtualMachine<StandardRules>;
+
+using PackedVirtualMachine = BasicVirtualMachine<PackedStandardRules>;
+
+//batch configuration, nothing is recorded per instruction
+using HeadlessVirtualMachine = BasicVirtualMachine<PackedStandardRules, VirtualMachineBase::NullReport>;
+
+//batch configuration counting the accessed cells, see HeatmapReport
+using HeatmappedVirtualMachine = BasicVirtualMachine<PackedStandardRules, VirtualMachineBase::HeatmapReport>;
+
+//batch configuration counting the executed paths, see ProfileReport
+using ProfiledVirtualMachine = BasicVirtualMachine<PackedStandardRules, VirtualMachineBase::ProfileReport>;
+
+extern template class BasicVirtualMachine<RuntimeRules>;
+extern template class BasicVirtualMachine<StandardRules>;
+extern template class BasicVirtualMachine<PackedStandardRules>;
+
+extern template class BasicVirtualMachine<RuntimeRules, VirtualMachineBase::NullReport>;
+extern template class BasicVirtualMachine<StandardRules, VirtualMachineBase::NullReport>;
+extern template class BasicVirtualMachine<PackedStandardRules, VirtualMachineBase::NullReport>;
+
+extern template class BasicVirtualMachine<PackedStandardRules, VirtualMachineBase::HeatmapReport>;
+
+extern template class BasicVirtualMachine<PackedStandardRules, VirtualMachineBase::ProfileReport>;
+
+//******************************************************************************
+//PACKED_INSTRUCTION
+//******************************************************************************
+
+static_assert(sizeof(VirtualMachineBase::PackedInstruction) == sizeof(std::uint64_t),
+			  "PackedInstruction must fit a 64-bit word");
+
+inline VirtualMachineBase::PackedInstruction::operator Instruction() const
+{
+	return Instruction(op, mod, aVal, bVal, aMode, bMode);
+}
+
+inline bool VirtualMachineBase::PackedInstruction::operator==(const PackedInstruction& other) const
+{
+	std::uint64_t lhs, rhs;
+
+	std::memcpy(&lhs, this, sizeof(lhs));
+	std::memcpy(&rhs, &other, sizeof(rhs));
+
+	return lhs == rhs;
+}
+
+inline bool VirtualMachineBase::PackedInstruction::operator!=(const PackedInstruction& other) const
+{
+	return !operator==(other);
+}
+
 //******************************************************************************
 //PROGRAM_PTR
 //******************************************************************************
 
-class VirtualMachine::Core::ProgramPtr
+template<class Rules, class Report>
+class BasicVirtualMachine<Rules, Report>::Core::ProgramPtr
 {
 public:
 
-	explicit ProgramPtr(std::vector<Core::Instruction>::iterator i, const Core& r) : it_(i),
-		ref_(const_cast<Core&>(r)) {}
-
-	ProgramPtr& operator=(const ProgramPtr&);
+	explicit ProgramPtr(unsigned int p, const Core& r) : pos_(p),
+		core_(const_cast<Core*>(&r)) {}
 
-	Core::Instruction& operator*();
-	Core::Instruction* operator->();
+	Cell& operator*();
+	Cell* operator->();
 
 	ProgramPtr operator+(unsigned int);
 
@@ -179,9 +815,186 @@ public:
 
 private:
 
-	std::vector<Core::Instruction>::iterator it_;
+	unsigned int pos_;
 
-	Core& ref_;
+	Core* core_;
 };
 
+template<class Rules, class Report>
+inline auto BasicVirtualMachine<Rules, Report>::Core::begin() -> ProgramPtr
+{
+	return ProgramPtr(0, *this);
+}
+
+template<class Rules, class Report>
+inline auto BasicVirtualMachine<Rules, Report>::Core::at(unsigned int n) -> ProgramPtr
+{
+	return ProgramPtr(n, *this);
+}
+
+template<class Rules, class Report>
+inline unsigned int BasicVirtualMachine<Rules, Report>::Core::getSize() const
+{
+	return Rules::coreSize ? Rules::coreSize : size_;
+}
+
+template<class Rules, class Report>
+inline unsigned int BasicVirtualMachine<Rules, Report>::Core::mask() const
+{
+	return Rules::coreSize ? fixedMask() : mask_;
+}
+
+template<class Rules, class Report>
+inline unsigned int BasicVirtualMachine<Rules, Report>::Core::wrap(unsigned int n) const
+{
+	if(mask())
+		return n & mask();
+
+	return n >= getSize() ? n - getSize() : n;
+}
+
+template<class Rules, class Report>
+inline unsigned int BasicVirtualMachine<Rules, Report>::Core::normalize(unsigned int n) const
+{
+	if(mask())
+		return n & mask();
+
+	return n % getSize();
+}
+
+template<class Rules, class Report>
+inline auto BasicVirtualMachine<Rules, Report>::Core::ProgramPtr::operator*() -> Cell&
+{
+	return core_->memory_[pos_];
+}
+
+template<class Rules, class Report>
+inline auto BasicVirtualMachine<Rules, Report>::Core::ProgramPtr::operator->() -> Cell*
+{
+	return &core_->memory_[pos_];
+}
+
+template<class Rules, class Report>
+inline auto BasicVirtualMachine<Rules, Report>::Core::ProgramPtr::operator+(unsigned int n) -> ProgramPtr
+{
+	ProgramPtr result = *this;
+
+	result += n;
+
+	return result;
+}
+
+//n is expected to be a normalized offset, as every field in the core is
+template<class Rules, class Report>
+inline auto BasicVirtualMachine<Rules, Report>::Core::ProgramPtr::operator+=(unsigned int n) -> ProgramPtr&
+{
+	pos_ = core_->wrap(pos_ + n);
+
+	return *this;
+}
+
+template<class Rules, class Report>
+inline auto BasicVirtualMachine<Rules, Report>::Core::ProgramPtr::operator++() -> ProgramPtr&
+{
+	pos_ = core_->wrap(pos_ + 1);
+
+	return *this;
+}
+
+template<class Rules, class Report>
+inline auto BasicVirtualMachine<Rules, Report>::Core::ProgramPtr::operator++(int) -> ProgramPtr
+{
+	ProgramPtr ret = *this;
+
+	++(*this);
+
+	return ret;
+}
+
+template<class Rules, class Report>
+inline unsigned int BasicVirtualMachine<Rules, Report>::Core::ProgramPtr::pos() const
+{
+	return pos_;
+}
+
+//******************************************************************************
+//PROCESS_QUEUE
+//******************************************************************************
+
+template<class Rules, class Report>
+inline BasicVirtualMachine<Rules, Report>::ProcessQueue::ProcessQueue(unsigned int capacity)
+	: head_(0),
+	  size_(0),
+	  peak_(0)
+{
+	initStorage(slots_, capacity, 0u);
+}
+
+template<class Rules, class Report>
+inline bool BasicVirtualMachine<Rules, Report>::ProcessQueue::empty() const
+{
+	return !size_;
+}
+
+template<class Rules, class Report>
+inline unsigned int BasicVirtualMachine<Rules, Report>::ProcessQueue::size() const
+{
+	return size_;
+}
+
+template<class Rules, class Report>
+inline unsigned int BasicVirtualMachine<Rules, Report>::ProcessQueue::capacity() const
+{
+	return slots_.size();
+}
+
+template<class Rules, class Report>
+inline unsigned int BasicVirtualMachine<Rules, Report>::ProcessQueue::peak() const
+{
+	return peak_;
+}
+
+template<class Rules, class Report>
+inline unsigned int BasicVirtualMachine<Rules, Report>::ProcessQueue::front() const
+{
+	return slots_[head_];
+}
+
+template<class Rules, class Report>
+inline void BasicVirtualMachine<Rules, Report>::ProcessQueue::push(unsigned int offset)
+{
+	unsigned int tail = head_ + size_;
+
+	if(tail >= slots_.size())
+		tail -= slots_.size();
+
+	slots_[tail] = offset;
+
+	if(++size_ > peak_)
+		peak_ = size_;
+}
+
+template<class Rules, class Report>
+inline void BasicVirtualMachine<Rules, Report>::ProcessQueue::push(const ProgramPtr& p)
+{
+	push(p.pos());
+}
+
+template<class Rules, class Report>
+inline void BasicVirtualMachine<Rules, Report>::ProcessQueue::pop()
+{
+	if(++head_ == slots_.size())
+		head_ = 0;
+
+	--size_;
+}
+
+template<class Rules, class Report>
+inline void BasicVirtualMachine<Rules, Report>::ProcessQueue::clear()
+{
+	head_ = 0;
+	size_ = 0;
+	peak_ = 0;
+}
+
 #endif //VIRTUALMACHINE_HPP
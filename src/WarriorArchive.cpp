@@ -0,0 +1,246 @@
+#include "WarriorArchive.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+namespace
+{
+
+const char Magic[4] = {'C', 'W', 'A', 'R'};
+
+const std::uint16_t ByteOrderMark = 0xFEFF;
+
+const std::size_t Alignment = 8;
+
+std::uint16_t get16(const char* p)
+{
+	const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+
+	return static_cast<std::uint16_t>(u[0] | u[1] << 8);
+}
+
+std::uint32_t get32(const char* p)
+{
+	return get16(p) | static_cast<std::uint32_t>(get16(p + 2)) << 16;
+}
+
+std::uint64_t get64(const char* p)
+{
+	return get32(p) | static_cast<std::uint64_t>(get32(p + 4)) << 32;
+}
+
+void put16(char* p, std::uint16_t n)
+{
+	p[0] = static_cast<char>(n & 0xff);
+	p[1] = static_cast<char>(n >> 8);
+}
+
+void put32(char* p, std::uint32_t n)
+{
+	put16(p, static_cast<std::uint16_t>(n & 0xffff));
+	put16(p + 2, static_cast<std::uint16_t>(n >> 16));
+}
+
+void put64(char* p, std::uint64_t n)
+{
+	put32(p, static_cast<std::uint32_t>(n & 0xffffffff));
+	put32(p + 4, static_cast<std::uint32_t>(n >> 32));
+}
+
+std::uint32_t checksum(const char* p, std::size_t size)
+{
+	//FNV-1a
+	std::uint32_t h = 2166136261u;
+
+	for(std::size_t i = 0; i < size; ++i)
+		h = (h ^ static_cast<unsigned char>(p[i])) * 16777619u;
+
+	return h;
+}
+
+std::uint64_t hash(const char* p, std::size_t size)
+{
+	//FNV-1a
+	std::uint64_t h = 14695981039346656037ull;
+
+	for(std::size_t i = 0; i < size; ++i)
+		h = (h ^ static_cast<unsigned char>(p[i])) * 1099511628211ull;
+
+	return h;
+}
+
+std::size_t align(std::size_t n)
+{
+	return (n + Alignment - 1) & ~(Alignment - 1);
+}
+
+}
+
+WarriorArchive::WarriorArchive(const char* fname)
+	: file_(new MappedFile(fname))
+{
+	parse(file_->data(), file_->size());
+}
+
+WarriorArchive::WarriorArchive(const char* data, std::size_t size)
+{
+	parse(data, size);
+}
+
+std::string WarriorArchive::encode(const std::vector<Member>& members, unsigned int coreSize)
+{
+	std::unordered_map<std::string_view, unsigned int> seen;
+
+	std::size_t indexEnd = HeaderSize + members.size() * EntrySize;
+	std::size_t namesEnd = indexEnd;
+
+	for(const auto& m : members)
+	{
+		if(m.name.size() > 0xffff)
+			throw std::invalid_argument("Warrior name is too long: " + m.name);
+
+		if(!seen.emplace(m.name, 0).second)
+			throw std::invalid_argument("Warrior name repeated in archive: " + m.name);
+
+		namesEnd += m.name.size();
+	}
+
+	std::string out(align(namesEnd), '\0');
+
+	std::memcpy(&out[0], Magic, sizeof(Magic));
+
+	put16(&out[4], Version);
+	put16(&out[6], ByteOrderMark);
+	put32(&out[8], members.size());
+
+	std::size_t name = indexEnd;
+
+	for(std::size_t i = 0; i < members.size(); ++i)
+	{
+		const Member& m = members[i];
+
+		std::string body = ObjectFile::encode(m.instructions, coreSize);
+
+		char* entry = &out[HeaderSize + i * EntrySize];
+
+		put32(entry, name);
+		put16(entry + 4, static_cast<std::uint16_t>(m.name.size()));
+		put32(entry + 8, out.size());
+		put32(entry + 12, body.size());
+		put64(entry + 16, hash(body.data(), body.size()));
+
+		std::memcpy(&out[name], m.name.data(), m.name.size());
+
+		name += m.name.size();
+
+		body.resize(align(body.size()), '\0');
+
+		out += body;
+	}
+
+	put32(&out[12], checksum(out.data() + HeaderSize, namesEnd - HeaderSize));
+
+	return out;
+}
+
+void WarriorArchive::write(const char* fname, const std::vector<Member>& members, unsigned int coreSize)
+{
+	std::string image = encode(members, coreSize);
+
+	std::ofstream fout(fname, std::ofstream::out |
+					   std::ofstream::binary |
+					   std::ofstream::trunc);
+
+	fout.write(image.data(), image.size());
+
+	if(!fout)
+		throw std::runtime_error(std::string("Cannot write ") + fname);
+}
+
+unsigned int WarriorArchive::size() const
+{
+	return members_.size();
+}
+
+std::string_view WarriorArchive::getName(unsigned int i) const
+{
+	return names_.at(i);
+}
+
+std::uint64_t WarriorArchive::getHash(unsigned int i) const
+{
+	return hashes_.at(i);
+}
+
+const ObjectFile& WarriorArchive::operator[](unsigned int i) const
+{
+	return members_.at(i);
+}
+
+int WarriorArchive::find(std::string_view name) const
+{
+	auto it = index_.find(name);
+
+	if(it == index_.end())
+		return NotFound;
+
+	return it->second;
+}
+
+void WarriorArchive::parse(const char* data, std::size_t size)
+{
+	if(size < HeaderSize || std::memcmp(data, Magic, sizeof(Magic)))
+		throw std::runtime_error("Not a warrior archive");
+
+	if(get16(data + 4) != Version)
+		throw std::runtime_error("Unsupported warrior archive version");
+
+	if(get16(data + 6) != ByteOrderMark)
+		throw std::runtime_error("Warrior archive has the wrong byte order");
+
+	std::size_t count = get32(data + 8);
+
+	if(count > (size - HeaderSize) / EntrySize)
+		throw std::runtime_error("Warrior archive index is truncated");
+
+	std::size_t namesEnd = HeaderSize + count * EntrySize;
+
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const char* entry = data + HeaderSize + i * EntrySize;
+
+		std::size_t end = get32(entry) + static_cast<std::size_t>(get16(entry + 4));
+
+		if(end > size)
+			throw std::runtime_error("Warrior archive index is truncated");
+
+		namesEnd = std::max(namesEnd, end);
+	}
+
+	if(checksum(data + HeaderSize, namesEnd - HeaderSize) != get32(data + 12))
+		throw std::runtime_error("Warrior archive checksum mismatch");
+
+	names_.reserve(count);
+	hashes_.reserve(count);
+	members_.reserve(count);
+
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const char* entry = data + HeaderSize + i * EntrySize;
+
+		std::size_t offset = get32(entry + 8);
+		std::size_t length = get32(entry + 12);
+
+		if(offset % Alignment || offset > size || length > size - offset)
+			throw std::runtime_error("Warrior archive holds an invalid member");
+
+		names_.emplace_back(data + get32(entry), get16(entry + 4));
+		hashes_.push_back(get64(entry + 16));
+		members_.emplace_back(data + offset, length);
+
+		if(!index_.emplace(names_.back(), i).second)
+			throw std::runtime_error("Warrior name repeated in archive");
+	}
+}
@@ -0,0 +1,102 @@
+#ifndef WARRIORARCHIVE_HPP
+#define WARRIORARCHIVE_HPP
+
+#include "ObjectFile.hpp"
+#include "MappedFile.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*!
+ * \brief Many compiled warriors in a single mapped file
+ *
+ * Little-endian layout: a 16 byte header (magic "CWAR", version, byte
+ * order marker, member count and an FNV-1a checksum of the index and
+ * the names), one 24 byte index entry per member (offset and length of
+ * its name, offset and length of its body, 64 bit FNV-1a hash of the
+ * body), the names, and finally the bodies. Every body is a complete
+ * ObjectFile image starting on an 8 byte boundary.
+ *
+ * The index and every body are validated when the archive is opened;
+ * the body hash identifies a compiled warrior and is not checked, the
+ * ObjectFile checksum covers the body already. Afterwards any
+ * member can be handed to BasicVirtualMachine::loadProgram straight
+ * from the mapping:
+ *
+ *     const ObjectFile& w = archive[archive.find("imp")];
+ *     vm.loadProgram(w.data(), w.size(), offset);
+ *
+ * Invalid archives throw std::runtime_error.
+ */
+class WarriorArchive
+{
+public:
+
+	using Instruction = ObjectFile::Instruction;
+
+	struct Member
+	{
+		std::string name;
+
+		std::vector<Instruction> instructions;
+	};
+
+	static constexpr std::uint16_t Version = 1;
+
+	static constexpr std::size_t HeaderSize = 16;
+	static constexpr std::size_t EntrySize = 24;
+
+	static constexpr int NotFound = -1;
+
+	/*!
+	 * \brief Maps and validates the given file
+	 */
+	explicit WarriorArchive(const char*);
+
+	/*!
+	 * \brief Validates an image owned by the caller, which has to outlive the WarriorArchive
+	 */
+	WarriorArchive(const char*, std::size_t);
+
+	/*!
+	 * \brief Image of the given members, throws std::invalid_argument on repeated names
+	 * or fields that do not fit
+	 */
+	static std::string encode(const std::vector<Member>&, unsigned int = 8000);
+
+	static void write(const char*, const std::vector<Member>&, unsigned int = 8000);
+
+	unsigned int size() const;
+
+	std::string_view getName(unsigned int) const;
+
+	std::uint64_t getHash(unsigned int) const;
+
+	const ObjectFile& operator[](unsigned int) const;
+
+	/*!
+	 * \brief Index of the member with the given name, NotFound if there is none
+	 */
+	int find(std::string_view) const;
+
+private:
+
+	void parse(const char*, std::size_t);
+
+	std::unique_ptr<MappedFile> file_;
+
+	std::vector<std::string_view> names_;
+
+	std::vector<std::uint64_t> hashes_;
+
+	std::vector<ObjectFile> members_;
+
+	std::unordered_map<std::string_view, unsigned int> index_;
+};
+
+#endif //WARRIORARCHIVE_HPP
@@ -2,10 +2,125 @@
 
 #include <cstdio>
 #include <fstream>
+#include <memory>
+#include <cstdint>
+#include <type_traits>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <stdexcept>
 
 #include "src/VirtualMachine.hpp"
 #include "src/Tokenizer.hpp"
+#include "src/Lexer.hpp"
 #include "src/Assembler.hpp"
+#include "src/SymbolTable.hpp"
+#include "src/AssemblyCache.hpp"
+#include "src/BulkAssembler.hpp"
+#include "src/Tournament.hpp"
+#include "src/ObjectFile.hpp"
+#include "src/WarriorArchive.hpp"
+#include "src/MatchRunner.hpp"
+#include "src/InstructionLog.hpp"
+#include "src/Heatmap.hpp"
+
+namespace
+{
+
+typedef VirtualMachine::Core::Instruction Instruction;
+
+//warriors the VM tests pit against each other
+const std::vector<Instruction> Imp = {
+	Instruction(Instruction::OpCode::MOV, Instruction::Modifier::I, 0, 1)
+};
+
+const std::vector<Instruction> Dwarf = {
+	Instruction(Instruction::OpCode::ADD, Instruction::Modifier::AB, 4, 3,
+				Instruction::AddressMode::IMM, Instruction::AddressMode::DIR),
+	Instruction(Instruction::OpCode::MOV, Instruction::Modifier::I, 2, 2,
+				Instruction::AddressMode::DIR, Instruction::AddressMode::BIN),
+	Instruction(Instruction::OpCode::JMP, Instruction::Modifier::B, 7998, 0,
+				Instruction::AddressMode::DIR, Instruction::AddressMode::IMM)
+};
+
+const std::vector<Instruction> Forker = {
+	Instruction(Instruction::OpCode::FRK, Instruction::Modifier::B, 0, 0,
+				Instruction::AddressMode::DIR, Instruction::AddressMode::IMM),
+	Instruction(Instruction::OpCode::JMP, Instruction::Modifier::B, 7999, 0,
+				Instruction::AddressMode::DIR, Instruction::AddressMode::IMM)
+};
+
+//the dwarf at 100 and the imp at 4100
+template<class VM>
+void loadDwarfAndImp(VM& vm)
+{
+	vm.loadProgram(Dwarf, 100);
+	vm.loadProgram(Imp, 4100, false);
+}
+
+//steps both machines together, false at the first cycle their reports differ
+template<class A, class B>
+bool runLockstep(A& lhs, B& rhs, unsigned int cycles)
+{
+	for(unsigned int i = 0; i < cycles; ++i)
+	{
+		lhs.executeCycle();
+		rhs.executeCycle();
+
+		if(lhs.getP1Report().toString() != rhs.getP1Report().toString() ||
+		   lhs.getP1Report().getExecutedAdr() != rhs.getP1Report().getExecutedAdr() ||
+		   lhs.getP2Report().toString() != rhs.getP2Report().toString() ||
+		   lhs.getP2Report().getExecutedAdr() != rhs.getP2Report().getExecutedAdr())
+			return false;
+	}
+
+	return true;
+}
+
+//a random name in the temporary directory, kept once create() succeeds
+//on it; creation fails on existing names, so no other process can be
+//handed the same one
+template<class Create>
+std::string tempPath(Create create)
+{
+	static std::mt19937 random(std::random_device{}());
+
+	for(int attempt = 0; attempt < 100; ++attempt)
+	{
+		std::string name = (std::filesystem::temp_directory_path() /
+							("CoreWarTests-" + std::to_string(random()))).string();
+
+		if(create(name))
+			return name;
+	}
+
+	throw std::runtime_error("Cannot create a temporary path");
+}
+
+std::string tempFile()
+{
+	return tempPath([](const std::string& name)
+	{
+		std::FILE* f = std::fopen(name.c_str(), "wbx");
+
+		if(f)
+			std::fclose(f);
+
+		return f != NULL;
+	});
+}
+
+std::string tempDirectory()
+{
+	return tempPath([](const std::string& name)
+	{
+		return std::filesystem::create_directory(name);
+	});
+}
+
+}
 
 class CoreWarTests : public QObject
 {
@@ -15,18 +130,42 @@ private slots:
 	void VM_coreZeroSizeException();
 	void VM_tooManyInstrException();
 	void VM_duplicatedPlayerException();
+	void VM_coreWrapping();
+	void VM_enginesAgree();
+	void VM_processQueuePeak();
+	void VM_standardRules();
+	void VM_packedCells();
+	void VM_runToCompletion();
+	void VM_nullReport();
+	void VM_profileReport();
+	void VM_concurrentMatches();
+	void VM_objectFile();
+	void VM_warriorArchive();
+	void VM_matchRunner();
+	void VM_instructionLog();
+	void VM_heatmap();
+	void VM_snapshot();
 
 	void TOK_noTokenException();
 	void TOK_readTokens();
 	void TOK_assignNewText();
 	void TOK_keptSeparators();
 	void TOK_toLowerCase();
+	void TOK_lexerViews();
 
 	void ASM_correctWarrior1();
 	void ASM_correctWarrior2();
 	void ASM_wrongInvalidInstruction();
 	void ASM_wrongInvalidLabel();
 	void ASM_wrongRepeatedLabel();
+	void ASM_assembleFromString();
+	void ASM_concurrentAssembly();
+	void ASM_forwardLabels();
+	void ASM_symbolTable();
+	void ASM_assemblyCache();
+	void ASM_bulkAssembly();
+
+	void TOUR_scoreMatrix();
 };
 
 void CoreWarTests::VM_coreZeroSizeException()
@@ -60,6 +199,939 @@ void CoreWarTests::VM_duplicatedPlayerException()
 	QVERIFY_EXCEPTION_THROWN(vm.loadProgram(vec, 0, false), std::runtime_error);
 }
 
+void CoreWarTests::VM_coreWrapping()
+{
+	VirtualMachine::Core core(8000);
+
+	QCOMPARE(core.wrap(7999), 7999u);
+	QCOMPARE(core.wrap(8000), 0u);
+	QCOMPARE(core.wrap(8005), 5u);
+	QCOMPARE(core.normalize(16005), 5u);
+
+	VirtualMachine::Core pow2(4096);
+
+	QCOMPARE(pow2.wrap(4099), 3u);
+	QCOMPARE(pow2.normalize(3 * 4096 + 7), 7u);
+
+	VirtualMachine::Core::ProgramPtr p = core.begin() + 7999;
+
+	QCOMPARE(p.pos(), 7999u);
+	QCOMPARE((++p).pos(), 0u);
+	QCOMPARE((p + 7998).pos(), 7998u);
+}
+
+void CoreWarTests::VM_enginesAgree()
+{
+	VirtualMachine sw(8000, VirtualMachine::SWITCH);
+	VirtualMachine pre(8000, VirtualMachine::PREDECODED);
+
+	loadDwarfAndImp(sw);
+	loadDwarfAndImp(pre);
+
+	QVERIFY(runLockstep(pre, sw, 5000));
+
+	//every opcode, modifier and pair of modes, on a core small enough to
+	//compare whole after each cycle; the instruction under test writes
+	//into itself and into the cells after it, which a process forked
+	//past it has already executed, so their decoding is cached
+	const unsigned int coreSize = 64;
+
+	//keeps out of the way at the other end of the core
+	std::vector<Instruction> idle = {
+		Instruction(Instruction::OpCode::JMP, Instruction::Modifier::B, 0, 0,
+					Instruction::AddressMode::DIR, Instruction::AddressMode::IMM)
+	};
+
+	for(unsigned int op = Instruction::KIL; op <= Instruction::BLT; ++op)
+		for(unsigned int mod = Instruction::A; mod <= Instruction::I; ++mod)
+			for(unsigned int aMode = Instruction::IMM; aMode <= Instruction::BIN; ++aMode)
+				for(unsigned int bMode = Instruction::IMM; bMode <= Instruction::BIN; ++bMode)
+					for(int a : {0, 1})
+					{
+						std::vector<Instruction> tested = {
+							Instruction(Instruction::OpCode::FRK, Instruction::Modifier::B, 4, 0,
+										Instruction::AddressMode::DIR, Instruction::AddressMode::IMM),
+							Instruction(Instruction::OpCode::FRK, Instruction::Modifier::B, 1, 0,
+										Instruction::AddressMode::DIR, Instruction::AddressMode::IMM),
+							Instruction(static_cast<Instruction::OpCode>(op), static_cast<Instruction::Modifier>(mod),
+										a, a + 2, static_cast<Instruction::AddressMode>(aMode),
+										static_cast<Instruction::AddressMode>(bMode)),
+							Instruction(Instruction::OpCode::JMP, Instruction::Modifier::B, 1, 2,
+										Instruction::AddressMode::DIR, Instruction::AddressMode::IMM),
+							Instruction(Instruction::OpCode::ADD, Instruction::Modifier::AB, -3, 20,
+										Instruction::AddressMode::DIR, Instruction::AddressMode::DIR),
+							Instruction(Instruction::OpCode::JMP, Instruction::Modifier::B, -5, 1,
+										Instruction::AddressMode::DIR, Instruction::AddressMode::IMM)
+						};
+
+						VirtualMachine switched(coreSize, VirtualMachine::SWITCH);
+						VirtualMachine decoded(coreSize, VirtualMachine::PREDECODED);
+
+						for(VirtualMachine* vm : {&switched, &decoded})
+						{
+							vm->loadProgram(tested, 0);
+							vm->loadProgram(idle, 32, false);
+						}
+
+						for(int i = 0; i < 100; ++i)
+						{
+							QVERIFY(runLockstep(decoded, switched, 1));
+							QCOMPARE(decoded.getState(), switched.getState());
+
+							for(unsigned int adr = 0; adr < coreSize; ++adr)
+								QVERIFY(decoded.getInstruction(adr) == switched.getInstruction(adr));
+						}
+					}
+
+	//a division by zero in one field still stores the other one, which
+	//turns the jmp 2 / jmp -2 loop into a jump to itself
+	std::vector<Instruction> divider = Assembler().assemble("frk 4\njmp 2\nnop 0, 0\njmp -2\ndiv.x #0, -3").instructions;
+	std::vector<Instruction> loop = Assembler().assemble("jmp 0").instructions;
+
+	for(VirtualMachine::Engine engine : {VirtualMachine::SWITCH, VirtualMachine::PREDECODED})
+	{
+		VirtualMachine vm(8000, engine);
+
+		vm.loadProgram(divider, 0);
+		vm.loadProgram(loop, 4000, false);
+
+		for(int i = 0; i < 10; ++i)
+			vm.executeCycle();
+
+		QCOMPARE(vm.getP1Report().getProcessCount(), 1u);
+
+		for(int i = 0; i < 4; ++i)
+		{
+			vm.executeCycle();
+
+			QCOMPARE(vm.getP1Report().getExecutedAdr(), 1u);
+		}
+	}
+}
+
+void CoreWarTests::VM_processQueuePeak()
+{
+	VirtualMachine vm;
+
+	vm.loadProgram(Forker, 0);
+	vm.loadProgram(Imp, 4000, false);
+
+	for(int i = 0; i < 200; ++i)
+		vm.executeCycle();
+
+	QCOMPARE(vm.getPeakProcessesP1(), 64u);
+	QCOMPARE(vm.getPeakProcessesP2(), 1u);
+
+	vm.reset();
+
+	QCOMPARE(vm.getPeakProcessesP1(), 0u);
+}
+
+void CoreWarTests::VM_standardRules()
+{
+	QVERIFY_EXCEPTION_THROWN(StandardVirtualMachine::Core(4096), std::invalid_argument);
+
+	VirtualMachine runtime(8000);
+	std::unique_ptr<StandardVirtualMachine> standard(new StandardVirtualMachine(8000, VirtualMachine::PREDECODED));
+
+	QCOMPARE(standard->getCoreSize(), 8000u);
+	QCOMPARE(standard->getMaxProcesses(), runtime.getMaxProcesses());
+	QCOMPARE(standard->getMaxCycles(), runtime.getMaxCycles());
+
+	loadDwarfAndImp(runtime);
+	loadDwarfAndImp(*standard);
+
+	QVERIFY(runLockstep(*standard, runtime, 5000));
+}
+
+void CoreWarTests::VM_packedCells()
+{
+	typedef VirtualMachine::Core::Instruction Instruction;
+	typedef VirtualMachineBase::PackedInstruction PackedInstruction;
+
+	QCOMPARE(sizeof(PackedInstruction), sizeof(std::uint64_t));
+	QCOMPARE(sizeof(Instruction), 12u);
+
+	Instruction wide(Instruction::OpCode::BNE, Instruction::Modifier::X, 7999, 4000,
+					 Instruction::AddressMode::AIN, Instruction::AddressMode::BIN);
+
+	PackedInstruction packed(wide);
+
+	QVERIFY(Instruction(packed) == wide);
+	QVERIFY(packed == PackedInstruction(wide));
+	QVERIFY(packed != PackedInstruction());
+
+	VirtualMachine wideVm(8000);
+	std::unique_ptr<PackedVirtualMachine> packedVm(new PackedVirtualMachine(8000, VirtualMachine::PREDECODED));
+
+	loadDwarfAndImp(wideVm);
+	loadDwarfAndImp(*packedVm);
+
+	QVERIFY(runLockstep(*packedVm, wideVm, 5000));
+}
+
+void CoreWarTests::VM_runToCompletion()
+{
+	std::vector<Instruction> suicide = {
+		Instruction(Instruction::OpCode::KIL)
+	};
+
+	VirtualMachine stepped;
+
+	loadDwarfAndImp(stepped);
+
+	unsigned int cycles = 0;
+
+	do
+	{
+		stepped.executeCycle();
+		++cycles;
+	}while(stepped.getState() == VirtualMachine::ONGOING);
+
+	VirtualMachine batched;
+
+	loadDwarfAndImp(batched);
+
+	VirtualMachine::MatchResult res = batched.runCycles(100);
+
+	QCOMPARE(res.state, VirtualMachine::ONGOING);
+	QCOMPARE(res.cycles, 100u);
+
+	res = batched.runToCompletion();
+
+	QCOMPARE(res.state, stepped.getState());
+	QCOMPARE(res.cycles, cycles);
+	QCOMPARE(res.p1Processes, stepped.getP1Report().getProcessCount());
+	QCOMPARE(res.p2Processes, stepped.getP2Report().getProcessCount());
+
+	VirtualMachine killed;
+
+	killed.loadProgram(Dwarf, 100);
+	killed.loadProgram(suicide, 4100, false);
+
+	res = killed.runToCompletion();
+
+	QCOMPARE(res.state, VirtualMachine::P1_WON);
+	QCOMPARE(res.cycles, 1u);
+	QCOMPARE(res.p2Processes, 0u);
+
+	QCOMPARE(killed.runCycles(10).cycles, 1u);
+}
+
+void CoreWarTests::VM_nullReport()
+{
+	QVERIFY(std::is_empty<VirtualMachineBase::NullReport>::value);
+
+	VirtualMachine reported;
+	std::unique_ptr<HeadlessVirtualMachine> headless(new HeadlessVirtualMachine(8000, VirtualMachine::PREDECODED));
+
+	reported.loadProgram(Dwarf, 100);
+	reported.loadProgram(Forker, 4100, false);
+
+	headless->loadProgram(Dwarf, 100);
+	headless->loadProgram(Forker, 4100, false);
+
+	VirtualMachine::MatchResult expected = reported.runToCompletion();
+	VirtualMachine::MatchResult res = headless->runToCompletion();
+
+	QCOMPARE(res.state, expected.state);
+	QCOMPARE(res.cycles, expected.cycles);
+	QCOMPARE(res.p1Processes, expected.p1Processes);
+	QCOMPARE(res.p2Processes, expected.p2Processes);
+}
+
+void CoreWarTests::VM_profileReport()
+{
+	std::vector<Instruction> p1 = {
+		Instruction(Instruction::OpCode::FRK, Instruction::Modifier::B, 2, 0,
+					Instruction::AddressMode::DIR, Instruction::AddressMode::IMM),
+		Instruction(Instruction::OpCode::DIV, Instruction::Modifier::A, 0, 1,
+					Instruction::AddressMode::IMM, Instruction::AddressMode::DIR),
+		Instruction(Instruction::OpCode::MOV, Instruction::Modifier::I, 0, 1)
+	};
+
+	for(auto engine : {VirtualMachine::SWITCH, VirtualMachine::PREDECODED})
+	{
+		std::unique_ptr<ProfiledVirtualMachine> vm(new ProfiledVirtualMachine(8000, engine));
+
+		vm->loadProgram(p1, 0);
+		vm->loadProgram(Imp, 4000, false);
+
+		vm->runCycles(100);
+
+		const VirtualMachine::ProfileReport& report = vm->getP1Report();
+
+		QCOMPARE(report.getExecutions(), 100ull);
+		QCOMPARE(report.getExecutions(Instruction::FRK, Instruction::B, Instruction::DIR, Instruction::IMM), 1ull);
+		QCOMPARE(report.getExecutions(Instruction::DIV, Instruction::A, Instruction::IMM, Instruction::DIR), 1ull);
+		QCOMPARE(report.getExecutions(Instruction::MOV, Instruction::I, Instruction::DIR, Instruction::DIR), 98ull);
+		QCOMPARE(report.getSpawns(), 1ull);
+		QCOMPARE(report.getKills(), 1ull);
+		QCOMPARE(report.getDivisionKills(), 1ull);
+		QCOMPARE(vm->getP2Report().getExecutions(Instruction::MOV, Instruction::I, Instruction::DIR, Instruction::DIR), 100ull);
+
+		VirtualMachine::ProfileReport total = vm->getP1Report();
+		total += vm->getP2Report();
+
+		QCOMPARE(total.getExecutions(), 200ull);
+
+		total.reset();
+
+		QCOMPARE(total.getExecutions(), 0ull);
+	}
+}
+
+void CoreWarTests::VM_concurrentMatches()
+{
+	std::vector<std::vector<Instruction>> warriors = {
+		Imp,
+		Dwarf,
+		{
+			Instruction(Instruction::OpCode::ADD, Instruction::Modifier::AB, 7, 3,
+						Instruction::AddressMode::IMM, Instruction::AddressMode::DIR),
+			Instruction(Instruction::OpCode::MOV, Instruction::Modifier::I, 2, 2,
+						Instruction::AddressMode::DIR, Instruction::AddressMode::BIN),
+			Instruction(Instruction::OpCode::JMP, Instruction::Modifier::B, 7998, 0,
+						Instruction::AddressMode::DIR, Instruction::AddressMode::IMM)
+		},
+		Forker
+	};
+
+	const unsigned int matches = 48;
+
+	auto play = [&warriors](unsigned int i) -> VirtualMachine::MatchResult
+	{
+		VirtualMachine vm;
+
+		vm.loadProgram(warriors[i % warriors.size()], i * 131);
+		vm.loadProgram(warriors[i / warriors.size() % warriors.size()], i * 131 + 4000, false);
+
+		while(vm.getState() == VirtualMachine::ONGOING)
+			vm.executeCycle();
+
+		return vm.getResult();
+	};
+
+	std::vector<VirtualMachine::MatchResult> serial;
+
+	for(unsigned int i = 0; i < matches; ++i)
+		serial.push_back(play(i));
+
+	std::vector<VirtualMachine::MatchResult> concurrent(matches);
+	std::vector<std::thread> threads;
+
+	for(unsigned int i = 0; i < matches; ++i)
+		threads.emplace_back([&play, &concurrent, i]() { concurrent[i] = play(i); });
+
+	for(auto& t : threads)
+		t.join();
+
+	for(unsigned int i = 0; i < matches; ++i)
+	{
+		QCOMPARE(concurrent[i].state, serial[i].state);
+		QCOMPARE(concurrent[i].cycles, serial[i].cycles);
+		QCOMPARE(concurrent[i].p1Processes, serial[i].p1Processes);
+		QCOMPARE(concurrent[i].p2Processes, serial[i].p2Processes);
+	}
+}
+
+void CoreWarTests::VM_objectFile()
+{
+	std::string image = ObjectFile::encode(Dwarf);
+
+	QCOMPARE(image.size(), ObjectFile::HeaderSize + 3 * 8);
+
+	ObjectFile view(image.data(), image.size());
+
+	QCOMPARE(view.size(), 3u);
+	QCOMPARE(view.getCoreSize(), 8000u);
+	QVERIFY(view.getInstructions() == Dwarf);
+
+	std::string name = tempFile();
+
+	ObjectFile::write(name.c_str(), Dwarf);
+
+	QVERIFY(ObjectFile(name.c_str()).getInstructions() == Dwarf);
+
+	//object and vector loaders agree, also when the program wraps around the core
+	VirtualMachine wideVm(8000), wideRef(8000);
+	std::unique_ptr<PackedVirtualMachine> packedVm(new PackedVirtualMachine(8000));
+
+	wideVm.loadProgram(name.c_str(), 7998);
+	wideVm.loadProgram(Imp, 4100, false);
+
+	packedVm->loadProgram(view.data(), view.size(), 7998);
+	packedVm->loadProgram(Imp, 4100, false);
+
+	remove(name.c_str());
+
+	wideRef.loadProgram(Dwarf, 7998);
+	wideRef.loadProgram(Imp, 4100, false);
+
+	QVERIFY(runLockstep(wideVm, wideRef, 5000));
+
+	wideRef.reset();
+	wideRef.loadProgram(Dwarf, 7998);
+	wideRef.loadProgram(Imp, 4100, false);
+
+	QVERIFY(runLockstep(*packedVm, wideRef, 5000));
+
+	std::string corrupted = image;
+
+	corrupted.back() ^= 1;
+
+	QVERIFY_EXCEPTION_THROWN(ObjectFile(corrupted.data(), corrupted.size()), std::runtime_error);
+	QVERIFY_EXCEPTION_THROWN(ObjectFile(image.data(), image.size() - 1), std::runtime_error);
+	QVERIFY_EXCEPTION_THROWN(ObjectFile(image.data(), 4), std::runtime_error);
+
+	std::vector<Instruction> oversized = {Instruction(Instruction::OpCode::KIL, Instruction::Modifier::F, 8000, 0)};
+
+	QVERIFY_EXCEPTION_THROWN(ObjectFile::encode(oversized), std::invalid_argument);
+	QVERIFY_EXCEPTION_THROWN(ObjectFile::encode(oversized, 70000), std::invalid_argument);
+
+	//-1 is stored as 799 for an 800 cell core, which would load as +799 on 8000 cells
+	Assembler::Result small = Assembler(800).assemble("jmp -1");
+
+	QVERIFY(small.success);
+
+	name = tempFile();
+
+	ObjectFile::write(name.c_str(), small.instructions, 800);
+
+	VirtualMachine smallVm(800), largeVm(8000);
+
+	smallVm.loadProgram(name.c_str(), 0);
+
+	QVERIFY_EXCEPTION_THROWN(largeVm.loadProgram(name.c_str(), 0), std::invalid_argument);
+
+	remove(name.c_str());
+
+	QVERIFY(!largeVm.isLoadedP1());
+}
+
+void CoreWarTests::VM_warriorArchive()
+{
+	std::vector<WarriorArchive::Member> members = {
+		{"dwarf", Dwarf},
+		{"imp", Imp},
+		{"odd", Assembler().assemble("kil 0, 0").instructions}
+	};
+
+	std::string name = tempFile();
+
+	WarriorArchive::write(name.c_str(), members);
+
+	WarriorArchive archive(name.c_str());
+
+	QCOMPARE(archive.size(), 3u);
+
+	for(unsigned int i = 0; i < archive.size(); ++i)
+	{
+		QCOMPARE(archive.find(members[i].name), static_cast<int>(i));
+		QCOMPARE(std::string(archive.getName(i)), members[i].name);
+		QVERIFY(archive[i].getInstructions() == members[i].instructions);
+
+		//bodies are used straight from the mapping
+		QVERIFY(reinterpret_cast<std::uintptr_t>(archive[i].data()) % 8 == 0);
+	}
+
+	QCOMPARE(archive.find("Imp"), WarriorArchive::NotFound);
+	QVERIFY(archive.getHash(0) != archive.getHash(1));
+
+	std::unique_ptr<PackedVirtualMachine> fromArchive(new PackedVirtualMachine(8000));
+	std::unique_ptr<PackedVirtualMachine> fromSource(new PackedVirtualMachine(8000));
+
+	fromArchive->loadProgram(archive[0].data(), archive[0].size(), 0);
+	fromArchive->loadProgram(archive[1].data(), archive[1].size(), 4000, false);
+
+	fromSource->loadProgram(members[0].instructions, 0);
+	fromSource->loadProgram(members[1].instructions, 4000, false);
+
+	QCOMPARE(fromArchive->runToCompletion().cycles, fromSource->runToCompletion().cycles);
+	QCOMPARE(fromArchive->getP1Report().toString(), fromSource->getP1Report().toString());
+
+	remove(name.c_str());
+
+	std::string image = WarriorArchive::encode(members);
+
+	std::string corrupted = image;
+
+	corrupted[WarriorArchive::HeaderSize + 8] ^= 1;
+
+	QVERIFY_EXCEPTION_THROWN(WarriorArchive(corrupted.data(), corrupted.size()), std::runtime_error);
+	QVERIFY_EXCEPTION_THROWN(WarriorArchive(image.data(), image.size() - 8), std::runtime_error);
+
+	members.push_back(members[0]);
+
+	QVERIFY_EXCEPTION_THROWN(WarriorArchive::encode(members), std::invalid_argument);
+}
+
+void CoreWarTests::VM_matchRunner()
+{
+	std::unique_ptr<StandardVirtualMachine> direct(new StandardVirtualMachine);
+
+	direct->loadProgram(Dwarf, 0);
+	direct->loadProgram(Imp, 4100, false);
+
+	VirtualMachine::MatchResult expected = direct->runToCompletion();
+
+	//owner of every cell as seen through the frames so far
+	std::vector<unsigned char> owner;
+
+	auto drain = [&owner](MatchRunner& runner, MatchRunner::Frame& all)
+	{
+		owner.resize(runner.getCoreSize());
+
+		for(int i = 0; i < 10000; ++i)
+		{
+			MatchRunner::Frame frame = runner.takeFrame();
+
+			//every cell is in a frame at most once
+			std::vector<bool> written(runner.getCoreSize());
+
+			for(auto adr : frame.p1Writes)
+			{
+				written.at(adr) = true;
+				owner[adr] = 1;
+			}
+
+			for(auto adr : frame.p2Writes)
+			{
+				QVERIFY(!written.at(adr));
+
+				written[adr] = true;
+				owner[adr] = 2;
+			}
+
+			all.p1Writes.insert(all.p1Writes.end(), frame.p1Writes.begin(), frame.p1Writes.end());
+			all.p2Writes.insert(all.p2Writes.end(), frame.p2Writes.begin(), frame.p2Writes.end());
+			all.p1Log.append(frame.p1Log);
+			all.p2Log.append(frame.p2Log);
+			all.result = frame.result;
+
+			if(!frame.running)
+				return;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	};
+
+	MatchRunner runner;
+
+	runner.load(Dwarf, 0);
+	runner.load(Imp, 4100, false);
+
+	QVERIFY(runner.isLoadedP1() && runner.isLoadedP2());
+
+	MatchRunner::Frame all;
+
+	runner.step();
+	runner.step();
+
+	drain(runner, all);
+
+	QCOMPARE(all.result.cycles, 2u);
+	QCOMPARE(all.p1Log.size(), static_cast<std::size_t>(2));
+	QCOMPARE(all.p1Log[1].cycle, 2u);
+
+	runner.start();
+
+	drain(runner, all);
+
+	QCOMPARE(all.result.state, expected.state);
+	QCOMPARE(all.result.cycles, expected.cycles);
+	QCOMPARE(all.result.p2Processes, expected.p2Processes);
+	//the log keeps only the newest cycles but counts them all
+	QCOMPARE(all.p1Log.getTotal(), static_cast<unsigned long long>(expected.cycles));
+	QCOMPARE(all.p1Log.size(), all.p1Log.capacity());
+	QCOMPARE(all.p1Log[all.p1Log.size() - 1].cycle, expected.cycles);
+
+	//the dwarf bombs every fourth cell
+	//both imps end up sweeping the whole core
+	QVERIFY(all.p2Writes.size() >= runner.getCoreSize());
+
+	//player 1 executes one instruction every cycle
+	Heatmap p1Heat, p2Heat;
+
+	runner.copyHeatmaps(p1Heat, p2Heat);
+
+	unsigned int executed = 0;
+
+	for(unsigned int adr = 0; adr < p1Heat.getSize(); ++adr)
+		executed += p1Heat.get(Heatmap::EXEC, adr);
+
+	QCOMPARE(executed, expected.cycles);
+
+	//a finished match does not start again
+	runner.start();
+
+	QCOMPARE(runner.takeFrame().running, false);
+
+	//paced, stopped before the end
+	runner.reset();
+	runner.load(Dwarf, 0);
+	runner.load(Imp, 4100, false);
+
+	runner.setInterval(std::chrono::milliseconds(1));
+	runner.start();
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+	runner.copyHeatmaps(p1Heat, p2Heat);
+
+	runner.stop();
+
+	all = MatchRunner::Frame();
+
+	drain(runner, all);
+
+	QCOMPARE(all.result.state, VirtualMachine::ONGOING);
+	QVERIFY(all.result.cycles > 0 && all.result.cycles < 1000);
+
+	//player 2 overwrites the cell player 1 bombed, which then only jumps
+	std::vector<VirtualMachine::Core::Instruction> bomber = Assembler().assemble("mov.i #0, 10\njmp 0").instructions;
+	std::vector<VirtualMachine::Core::Instruction> overwriter = Assembler().assemble("mov.i #0, -20\nmov.i #0, 10\njmp 0").instructions;
+
+	runner.reset();
+	runner.load(bomber, 0);
+	runner.load(overwriter, 30, false);
+
+	runner.step();
+	runner.step();
+	runner.step();
+
+	all = MatchRunner::Frame();
+	owner.assign(owner.size(), 0);
+
+	drain(runner, all);
+
+	QCOMPARE(all.result.cycles, 3u);
+	QCOMPARE(owner[10], static_cast<unsigned char>(2));
+	QCOMPARE(owner[41], static_cast<unsigned char>(2));
+	QCOMPARE(all.p1Writes.size(), static_cast<std::size_t>(0));
+
+	//player 2 does not run in the cycle player 1 dies in
+	runner.reset();
+	runner.load(Assembler().assemble("kil 0, 0").instructions, 0);
+	runner.load(Imp, 4100, false);
+
+	runner.start();
+
+	all = MatchRunner::Frame();
+
+	drain(runner, all);
+
+	QCOMPARE(all.result.state, VirtualMachine::P2_WON);
+	QCOMPARE(all.p1Log.size(), static_cast<std::size_t>(1));
+	QCOMPARE(all.p2Log.size(), static_cast<std::size_t>(0));
+
+	//the main window's sequence: positions past the end of the core, run
+	//paced, pause, step twice, resume flat out, then reset and play again
+	for(int match = 0; match < 2; ++match)
+	{
+		runner.reset();
+		runner.setInterval(std::chrono::milliseconds(1));
+		runner.load(Dwarf, 7000);
+		runner.load(Imp, 7000 + 5100, false);
+
+		runner.start();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		runner.stop();
+
+		all = MatchRunner::Frame();
+
+		drain(runner, all);
+
+		unsigned int paused = all.result.cycles;
+
+		QCOMPARE(all.result.state, VirtualMachine::ONGOING);
+		QCOMPARE(runner.takeFrame().result.cycles, paused);
+
+		runner.step();
+		runner.step();
+
+		drain(runner, all);
+
+		QCOMPARE(all.result.cycles, paused + 2);
+
+		runner.setInterval(std::chrono::nanoseconds(0));
+		runner.start();
+
+		drain(runner, all);
+
+		std::unique_ptr<StandardVirtualMachine> moved(new StandardVirtualMachine);
+
+		moved->loadProgram(Dwarf, 7000);
+		moved->loadProgram(Imp, 7000 + 5100, false);
+
+		VirtualMachine::MatchResult uninterrupted = moved->runToCompletion();
+
+		QCOMPARE(all.result.state, uninterrupted.state);
+		QCOMPARE(all.result.cycles, uninterrupted.cycles);
+		QCOMPARE(all.p1Log.getTotal(), static_cast<unsigned long long>(uninterrupted.cycles));
+
+		for(auto adr : all.p1Writes)
+			QVERIFY(adr < runner.getCoreSize());
+	}
+}
+
+void CoreWarTests::VM_instructionLog()
+{
+	QVERIFY_EXCEPTION_THROWN(InstructionLog(0), std::invalid_argument);
+
+
+	std::unique_ptr<StandardVirtualMachine> vm(new StandardVirtualMachine);
+
+	loadDwarfAndImp(*vm);
+
+	InstructionLog log(8);
+	std::vector<std::string> lines;
+
+	for(unsigned int i = 1; i <= 20; ++i)
+	{
+		vm->executeCycle();
+
+		VirtualMachine::StatReport& report = vm->getP1Report();
+
+		log.push(i, report.getExecutedAdr(), report.getInstruction());
+		lines.push_back(report.toString());
+
+		QCOMPARE(log.size(), static_cast<std::size_t>(std::min(i, 8u)));
+	}
+
+	//only the newest entries are kept, oldest first
+	QCOMPARE(log.capacity(), static_cast<std::size_t>(8));
+	QCOMPARE(log.getTotal(), 20ull);
+
+	for(std::size_t i = 0; i < log.size(); ++i)
+	{
+		QCOMPARE(log[i].cycle, static_cast<unsigned int>(13 + i));
+		QCOMPARE(InstructionLog::format(log[i]), lines[12 + i]);
+	}
+
+	//appending a longer log skips what would be dropped anyway
+	InstructionLog small(3);
+
+	small.push(1, 0, log[0].ins);
+	small.append(log);
+
+	QCOMPARE(small.size(), static_cast<std::size_t>(3));
+	QCOMPARE(small.getTotal(), 21ull);
+	QCOMPARE(small[0].cycle, 18u);
+	QCOMPARE(small[2].cycle, 20u);
+
+	log.clear();
+
+	QCOMPARE(log.size(), static_cast<std::size_t>(0));
+	QCOMPARE(log.getTotal(), 0ull);
+}
+
+void CoreWarTests::VM_heatmap()
+{
+	std::unique_ptr<StandardVirtualMachine> sw(new StandardVirtualMachine(8000, VirtualMachine::SWITCH));
+	std::unique_ptr<StandardVirtualMachine> pre(new StandardVirtualMachine(8000, VirtualMachine::PREDECODED));
+
+	for(auto vm : {sw.get(), pre.get()})
+	{
+		loadDwarfAndImp(*vm);
+	}
+
+	std::vector<unsigned int> executed(8000, 0);
+
+	for(int i = 0; i < 300; ++i)
+	{
+		sw->executeCycle();
+
+		++executed[sw->getP1Report().getExecutedAdr()];
+	}
+
+	pre->runCycles(300);
+
+	const Heatmap& p1 = sw->getP1Report().getHeatmap();
+	const Heatmap& p2 = sw->getP2Report().getHeatmap();
+
+	QCOMPARE(p1.getSize(), 8000u);
+
+	for(unsigned int adr = 0; adr < 8000; ++adr)
+		QCOMPARE(p1.get(Heatmap::EXEC, adr), executed[adr]);
+
+	//the imp executes and writes every cell ahead of it once
+	for(unsigned int adr = 4100; adr < 4400; ++adr)
+	{
+		QCOMPARE(p2.get(Heatmap::EXEC, adr), 1u);
+		QCOMPARE(p2.get(Heatmap::WRITE, adr + 1), 1u);
+	}
+
+	QCOMPARE(p2.getMax(Heatmap::EXEC), 1u);
+	QCOMPARE(p1.getMax(Heatmap::EXEC), 100u);
+	QVERIFY(p1.getMax(Heatmap::READ) > 0);
+
+	//both engines report the same accesses
+	QCOMPARE(Heatmap::toCsv(pre->getP1Report().getHeatmap(), pre->getP2Report().getHeatmap()),
+			 Heatmap::toCsv(p1, p2));
+
+	//and so does a packed machine that keeps nothing but the counts
+	std::unique_ptr<HeatmappedVirtualMachine> counted(new HeatmappedVirtualMachine);
+
+	loadDwarfAndImp(*counted);
+	counted->runCycles(300);
+
+	QCOMPARE(Heatmap::toCsv(counted->getP1Report().getHeatmap(), counted->getP2Report().getHeatmap()),
+			 Heatmap::toCsv(p1, p2));
+
+	//a report outside a machine counts the default core
+	VirtualMachine::StatReport standalone;
+
+	standalone.write(7999);
+
+	QCOMPARE(standalone.getHeatmap().getSize(), 8000u);
+	QCOMPARE(standalone.getHeatmap().get(Heatmap::WRITE, 7999), 1u);
+
+	std::string csv = Heatmap::toCsv(p1, p2);
+
+	QCOMPARE(static_cast<std::size_t>(std::count(csv.begin(), csv.end(), '\n')), static_cast<std::size_t>(8001));
+	QCOMPARE(csv.substr(0, csv.find('\n')), std::string("adr,p1_exec,p1_read,p1_write,p2_exec,p2_read,p2_write"));
+	QVERIFY(csv.find("\n4101,0,0,0,1,1,1\n") != std::string::npos);
+
+	Heatmap sum = p1;
+
+	sum += p1;
+
+	QCOMPARE(sum.get(Heatmap::EXEC, 100), 2 * p1.get(Heatmap::EXEC, 100));
+
+	//a copy shares the counters until either side adds to them
+	Heatmap before = pre->getP2Report().getHeatmap();
+
+	pre->executeCycle();
+
+	QCOMPARE(before.get(Heatmap::EXEC, 4400), 0u);
+	QCOMPARE(pre->getP2Report().getHeatmap().get(Heatmap::EXEC, 4400), 1u);
+
+	//and the copy writing first leaves the source alone
+	Heatmap copy = before;
+
+	copy.add(Heatmap::EXEC, 4400);
+	before.add(Heatmap::READ, 4400);
+
+	QCOMPARE(copy.get(Heatmap::EXEC, 4400), 1u);
+	QCOMPARE(copy.get(Heatmap::READ, 4400), 0u);
+	QCOMPARE(before.get(Heatmap::EXEC, 4400), 0u);
+	QCOMPARE(before.get(Heatmap::READ, 4400), 1u);
+
+	Heatmap assigned;
+
+	assigned.assign(before);
+	before.reset();
+
+	QCOMPARE(assigned.getSize(), 8000u);
+	QCOMPARE(assigned.get(Heatmap::READ, 4400), 1u);
+
+	QVERIFY_EXCEPTION_THROWN(sum += Heatmap(10), std::invalid_argument);
+	QVERIFY_EXCEPTION_THROWN(Heatmap::toCsv(p1, Heatmap(10)), std::invalid_argument);
+
+	//counts survive the VM reset, only the report drops them
+	sw->reset();
+
+	QCOMPARE(p1.get(Heatmap::EXEC, 100), 100u);
+
+	sw->getP1Report().reset();
+
+	QCOMPARE(p1.getMax(Heatmap::EXEC), 0u);
+	QCOMPARE(p1.getMax(Heatmap::WRITE), 0u);
+}
+
+void CoreWarTests::VM_snapshot()
+{
+	for(auto engine : {VirtualMachine::SWITCH, VirtualMachine::PREDECODED})
+	{
+		std::unique_ptr<StandardVirtualMachine> ref(new StandardVirtualMachine(8000, engine));
+		std::unique_ptr<StandardVirtualMachine> vm(new StandardVirtualMachine(8000, engine));
+
+		for(auto m : {ref.get(), vm.get()})
+		{
+			loadDwarfAndImp(*m);
+		}
+
+		QVERIFY(runLockstep(*ref, *vm, 500));
+
+		StandardVirtualMachine::Snapshot early = vm->snapshot();
+
+		vm->runCycles(400);
+
+		StandardVirtualMachine::Snapshot late = vm->snapshot();
+
+		QCOMPARE(early.getCycle(), 500u);
+		QCOMPARE(late.getCycle(), 900u);
+
+		//far past both snapshots, then back to the first
+		vm->runToCompletion();
+		vm->restore(early);
+
+		QCOMPARE(vm->getResult().cycles, 500u);
+		QCOMPARE(vm->getState(), VirtualMachine::ONGOING);
+
+		QVERIFY(runLockstep(*ref, *vm, 400));
+
+		//a snapshot restored into another machine plays on the same
+		std::unique_ptr<StandardVirtualMachine> other(new StandardVirtualMachine(8000, engine));
+
+		other->restore(late);
+
+		QVERIFY(other->isLoadedP1() && other->isLoadedP2());
+
+		QVERIFY(runLockstep(*ref, *other, 2000));
+
+		VirtualMachine::MatchResult expected = ref->runToCompletion();
+		VirtualMachine::MatchResult res = other->runToCompletion();
+
+		QCOMPARE(res.state, expected.state);
+		QCOMPARE(res.cycles, expected.cycles);
+		QCOMPARE(Heatmap::toCsv(other->getP1Report().getHeatmap(), other->getP2Report().getHeatmap()),
+				 Heatmap::toCsv(ref->getP1Report().getHeatmap(), ref->getP2Report().getHeatmap()));
+
+		//reset machines restore too
+		vm->reset();
+		vm->restore(late);
+
+		QCOMPARE(vm->getResult().cycles, 900u);
+		QVERIFY(vm->isLoadedP1() && vm->isLoadedP2());
+	}
+
+	//the last page of this core is only partly used
+	VirtualMachine odd(1000);
+
+	odd.loadProgram(Dwarf, 10);
+	odd.loadProgram(Imp, 500, false);
+
+	odd.runCycles(300);
+
+	VirtualMachine::Snapshot s = odd.snapshot();
+
+	std::vector<std::string> lines;
+
+	for(int i = 0; i < 300; ++i)
+	{
+		odd.executeCycle();
+
+		lines.push_back(odd.getP1Report().toString() + odd.getP2Report().toString());
+	}
+
+	odd.restore(s);
+
+	for(int i = 0; i < 300; ++i)
+	{
+		odd.executeCycle();
+
+		QCOMPARE(odd.getP1Report().toString() + odd.getP2Report().toString(), lines[i]);
+	}
+
+	VirtualMachine big(8000);
+
+	QVERIFY_EXCEPTION_THROWN(big.restore(odd.snapshot()), std::invalid_argument);
+}
+
 void CoreWarTests::TOK_noTokenException()
 {
 	Tokenizer t(std::string(), "");
@@ -105,6 +1177,32 @@ void CoreWarTests::TOK_toLowerCase()
 	QCOMPARE(t.next(), std::string("abcdefghijklmnopqrstuvwxyz"));
 }
 
+void CoreWarTests::TOK_lexerViews()
+{
+	std::string text = "MOV.I $1,\t#-2 ; Comment";
+
+	Lexer lex(text, " \t", ".,;");
+
+	std::string_view op = lex.next();
+
+	QVERIFY(op.data() == text.data());
+	QVERIFY(Lexer::equals(op, "mov"));
+	QVERIFY(!Lexer::equals(op, "mo"));
+	QCOMPARE(lex.next(), std::string_view("."));
+	QVERIFY(Lexer::equals(lex.next(), "i"));
+	QCOMPARE(lex.next(), std::string_view("$1"));
+	QCOMPARE(lex.next(), std::string_view(","));
+	QCOMPARE(lex.next(), std::string_view("#-2"));
+	QCOMPARE(lex.next(), std::string_view(";"));
+	QCOMPARE(lex.next(), std::string_view("Comment"));
+	QCOMPARE(lex.isToken(), false);
+	QVERIFY_EXCEPTION_THROWN(lex.next(), std::out_of_range);
+
+	lex.assign("  \t ");
+
+	QCOMPARE(lex.isToken(), false);
+}
+
 void CoreWarTests::ASM_correctWarrior1()
 {
 	const char* name = std::tmpnam(NULL);
@@ -190,7 +1288,301 @@ void CoreWarTests::ASM_wrongRepeatedLabel()
 	remove(name);
 }
 
+void CoreWarTests::ASM_assembleFromString()
+{
+	const char* source = "start: mov.i 2, 0\nkil 0, 0 ; comment\njmp start";
+
+	std::string name = tempFile();
+
+	std::ofstream out(name);
+
+	out << source;
+
+	out.close();
+
+	Assembler::getInstance().openFile(name.c_str());
+
+	QCOMPARE(Assembler::getInstance().assembly(), true);
+
+	remove(name.c_str());
+
+	Assembler::Result res = Assembler().assemble(source);
+
+	QCOMPARE(res.success, true);
+	QVERIFY(res.diagnostics.empty());
+	QVERIFY(res.instructions == Assembler::getInstance().getInstructions());
+	QCOMPARE(res.instructions.back().aVal, 7998u);
+
+	QCOMPARE(Assembler(4000).assemble(source).instructions.back().aVal, 3998u);
+
+	res = Assembler().assemble("ab: sub 20, 30\njmp abc\nab: kil 0, 0");
+
+	QCOMPARE(res.success, false);
+	QVERIFY(res.instructions.empty());
+	QCOMPARE(res.diagnostics.size(), static_cast<std::size_t>(2));
+	QCOMPARE(res.diagnostics[0].line, 3u);
+	QCOMPARE(res.diagnostics[1].line, 2u);
+	QCOMPARE(res.diagnostics[1].message, std::string("Label 'abc' does not exist"));
+
+	QVERIFY_EXCEPTION_THROWN(Assembler(0), std::invalid_argument);
+}
+
+void CoreWarTests::ASM_concurrentAssembly()
+{
+	const unsigned int sources = 64;
+
+	auto source = [](unsigned int i)
+	{
+		std::string s;
+
+		for(unsigned int l = 0; l <= i; ++l)
+			s += "l" + std::to_string(l) + ": add.ab #" + std::to_string(i) + ", l" + std::to_string(i - l) + "\n";
+
+		return s + "jmp l0\n";
+	};
+
+	Assembler as;
+
+	std::vector<Assembler::Result> serial;
+
+	for(unsigned int i = 0; i < sources; ++i)
+		serial.push_back(as.assemble(source(i)));
+
+	std::vector<Assembler::Result> concurrent(sources);
+	std::vector<std::thread> threads;
+
+	for(unsigned int t = 0; t < 4; ++t)
+		threads.emplace_back([&, t]()
+		{
+			for(unsigned int i = t; i < sources; i += 4)
+				concurrent[i] = as.assemble(source(i));
+		});
+
+	for(auto& t : threads)
+		t.join();
+
+	for(unsigned int i = 0; i < sources; ++i)
+	{
+		QCOMPARE(concurrent[i].success, true);
+		QCOMPARE(concurrent[i].instructions.size(), static_cast<std::size_t>(i + 2));
+		QVERIFY(concurrent[i].instructions == serial[i].instructions);
+	}
+}
+
+void CoreWarTests::ASM_forwardLabels()
+{
+	Assembler::Result res = Assembler().assemble("Top: jmp End\n"
+												 "     mov.i Top, @end ; back and forth\n"
+												 "\n"
+												 "END:\n"
+												 "     kil #0, #0\n");
+
+	QCOMPARE(res.success, true);
+	QCOMPARE(res.instructions.size(), static_cast<std::size_t>(3));
+	QCOMPARE(res.instructions[0].aVal, 2u);
+	QCOMPARE(res.instructions[1].aVal, 7999u);
+	QCOMPARE(res.instructions[1].bVal, 1u);
+	QCOMPARE(res.instructions[1].bMode, VirtualMachine::Core::Instruction::AddressMode::BIN);
+
+	res = Assembler().assemble("mov #end, 1\nend: kil 0, 0");
+
+	QCOMPARE(res.success, false);
+	QCOMPARE(res.diagnostics.size(), static_cast<std::size_t>(1));
+	QCOMPARE(res.diagnostics[0].message, std::string("Label address cannot be immediate"));
+}
+
+void CoreWarTests::ASM_symbolTable()
+{
+	std::vector<std::string> names;
+
+	for(unsigned int i = 0; i < 1000; ++i)
+		names.push_back("Label" + std::to_string(i));
+
+	SymbolTable table;
+
+	for(unsigned int i = 0; i < names.size(); ++i)
+		QCOMPARE(table.intern(names[i]), i);
+
+	QCOMPARE(table.size(), names.size());
+	QCOMPARE(table.intern("LABEL999"), 999u);
+	QCOMPARE(table.intern("label0"), 0u);
+	QCOMPARE(table.value(5), SymbolTable::Undefined);
+	QCOMPARE(table.define(5, 42), true);
+	QCOMPARE(table.define(table.intern("LABEL5"), 7), false);
+	QCOMPARE(table.value(5), 42);
+	QCOMPARE(table.size(), names.size());
+
+	//lookups of known labels at the growth threshold do not add anything
+	SymbolTable full;
+
+	for(unsigned int i = 0; i < 32; ++i)
+		full.intern(names[i]);
+
+	for(unsigned int i = 0; i < 32; ++i)
+		QCOMPARE(full.intern(names[i]), i);
+
+	QCOMPARE(full.size(), static_cast<std::size_t>(32));
+	QCOMPARE(full.intern(names[32]), 32u);
+	QCOMPARE(full.intern(names[0]), 0u);
+}
+
+void CoreWarTests::ASM_assemblyCache()
+{
+	//a cache of its own, so no entry of an earlier run is hit
+	std::string dir = tempDirectory();
+	std::string source = "start: mov.i 2, 0\njmp start";
+
+	AssemblyCache cache(dir);
+
+	Assembler::Result miss = cache.assemble(source);
+	Assembler::Result hit = cache.assemble(source);
+
+	QCOMPARE(cache.getMisses(), 1u);
+	QCOMPARE(cache.getHits(), 1u);
+	QCOMPARE(hit.success, true);
+	QVERIFY(hit.instructions == miss.instructions);
+	QVERIFY(hit.instructions == Assembler().assemble(source).instructions);
+
+	//the core size is part of the key
+	QVERIFY(AssemblyCache(dir, 4000).assemble(source).instructions == Assembler(4000).assemble(source).instructions);
+
+	std::string entry = cache.getEntryPath(AssemblyCache::key(source.data(), source.size(), 8000));
+
+	std::ofstream(entry, std::ofstream::binary | std::ofstream::trunc) << "garbage";
+
+	QVERIFY(cache.assemble(source).instructions == miss.instructions);
+	QCOMPARE(cache.getMisses(), 2u);
+	QVERIFY(cache.assemble(source).instructions == miss.instructions);
+	QCOMPARE(cache.getHits(), 2u);
+
+	//failures are not stored
+	Assembler::Result failed = cache.assemble("jmp nowhere");
+
+	QCOMPARE(failed.success, false);
+	QCOMPARE(failed.diagnostics.size(), static_cast<std::size_t>(1));
+	QCOMPARE(cache.assemble("jmp nowhere").diagnostics.size(), static_cast<std::size_t>(1));
+	QCOMPARE(cache.getHits(), 2u);
+
+	std::filesystem::remove_all(dir);
+
+	QVERIFY(AssemblyCache::key("a", 1, 8000) != AssemblyCache::key("a", 1, 8001));
+}
+
+void CoreWarTests::ASM_bulkAssembly()
+{
+	namespace fs = std::filesystem;
+
+	fs::path dir = tempDirectory();
+
+	const unsigned int sources = 40;
+
+	std::vector<std::string> files;
+
+	for(unsigned int i = 0; i < sources; ++i)
+	{
+		std::string fname = (dir / ("w" + std::to_string(100 + i) + ".red")).string();
+
+		std::ofstream out(fname);
+
+		//every fifth source refers to a missing label twice
+		for(unsigned int l = 0; l <= i; ++l)
+			out << "l" << l << ": add.ab #" << i << ", l" << i - l << "\n";
+
+		out << (i % 5 ? "jmp l0\n" : "jmp nope\njmp nope\n");
+
+		files.push_back(fname);
+	}
+
+	std::ofstream(dir / "notes.txt") << "not a warrior";
+
+	QVERIFY(BulkAssembler::listSources(dir.string()) == files);
 
+	BulkAssembler bulk(8000, 4);
+
+	std::vector<BulkAssembler::Unit> units = bulk.assemble(files);
+
+	QCOMPARE(units.size(), static_cast<std::size_t>(sources));
+
+	for(unsigned int i = 0; i < sources; ++i)
+	{
+		Assembler::Result serial = Assembler().assembleFile(files[i].c_str());
+
+		QCOMPARE(units[i].fname, files[i]);
+		QCOMPARE(units[i].result.success, serial.success);
+		QVERIFY(units[i].result.instructions == serial.instructions);
+		QCOMPARE(units[i].result.diagnostics.size(), serial.diagnostics.size());
+		QCOMPARE(units[i].result.diagnostics.size(), static_cast<std::size_t>(i % 5 ? 0 : 2));
+	}
+
+	bulk.setCache(dir.string());
+
+	units = bulk.assemble(files);
+
+	QCOMPARE(units[1].result.success, true);
+	QVERIFY(units[1].result.instructions == Assembler().assembleFile(files[1].c_str()).instructions);
+
+	fs::remove_all(dir);
+
+	QVERIFY_EXCEPTION_THROWN(BulkAssembler::listSources(dir.string()), std::runtime_error);
+}
+
+void CoreWarTests::TOUR_scoreMatrix()
+{
+	std::vector<std::vector<Instruction>> warriors = {
+		Imp,
+		Dwarf,
+		Forker,
+		{
+			Instruction(Instruction::OpCode::KIL)
+		}
+	};
+
+	const unsigned int rounds = 6;
+
+	Tournament serial(rounds, 42, 1);
+	Tournament parallel(rounds, 42, 4);
+
+	for(const auto& w : warriors)
+	{
+		serial.addWarrior(w);
+		parallel.addWarrior(w);
+	}
+
+	serial.run();
+	parallel.run();
+
+	for(unsigned int a = 0; a < warriors.size(); ++a)
+		for(unsigned int b = 0; b < warriors.size(); ++b)
+		{
+			const Tournament::Score& s = parallel.getScore(a, b);
+
+			QCOMPARE(s.wins, serial.getScore(a, b).wins);
+			QCOMPARE(s.losses, serial.getScore(a, b).losses);
+			QCOMPARE(s.draws, serial.getScore(a, b).draws);
+
+			QCOMPARE(s.wins, parallel.getScore(b, a).losses);
+			QCOMPARE(s.draws, parallel.getScore(b, a).draws);
+			QCOMPARE(s.wins + s.losses + s.draws, a == b ? 0u : rounds);
+		}
+
+	//the suicide warrior loses every round
+	QCOMPARE(parallel.getScore(1, 3).wins, rounds);
+
+	QCOMPARE(parallel.getProfile().getExecutions(), 0ull);
+
+	serial.setProfiling(true);
+	parallel.setProfiling(true);
+
+	serial.run();
+	parallel.run();
+
+	QVERIFY(parallel.getProfile().getExecutions() > 0);
+	QCOMPARE(parallel.getProfile().getExecutions(), serial.getProfile().getExecutions());
+	QCOMPARE(parallel.getProfile().getSpawns(), serial.getProfile().getSpawns());
+	QCOMPARE(parallel.getScore(1, 3).wins, rounds);
+
+	QVERIFY_EXCEPTION_THROWN(parallel.addWarrior(std::vector<Instruction>()), std::invalid_argument);
+}
 
 QTEST_MAIN(CoreWarTests)
 #include "CoreWarTests.moc"